@@ -0,0 +1,61 @@
+#include "ast_arena.hpp"
+
+// system includes
+#include <cstdint>
+
+void * AstArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+	if (bytes == 0)
+	{
+		bytes = 1;
+	}
+
+	// Padding needed to align the cursor
+	std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+
+	if (cursor == nullptr || padding + bytes > remaining)
+	{
+		// Blocks come from new[], which is aligned for any fundamental type
+		if (bytes + alignment > BLOCK_SIZE / 4)
+		{
+			// A large request gets its own block so the current one keeps its space
+			blocks.emplace_back(new unsigned char[bytes + alignment]);
+			unsigned char * block = blocks.back().get();
+			std::size_t offset = (alignment - reinterpret_cast<std::uintptr_t>(block) % alignment) % alignment;
+			used += bytes;
+			return block + offset;
+		}
+
+		blocks.emplace_back(new unsigned char[BLOCK_SIZE]);
+		cursor = blocks.back().get();
+		remaining = BLOCK_SIZE;
+		padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+	}
+
+	void * result = cursor + padding;
+	cursor += padding + bytes;
+	remaining -= padding + bytes;
+	used += bytes;
+	return result;
+}
+
+void AstArena::adopt(AstArena && other)
+{
+	blocks.reserve(blocks.size() + other.blocks.size());
+	for (auto & block : other.blocks)
+	{
+		blocks.push_back(std::move(block));
+	}
+	used += other.used;
+
+	other.blocks.clear();
+	other.cursor = nullptr;
+	other.remaining = 0;
+	other.used = 0;
+}
+
+void AstArena::retain(std::shared_ptr<AstArena> other)
+{
+	used += other->bytesUsed();
+	retained.push_back(std::move(other));
+}
@@ -0,0 +1,54 @@
+#ifndef AST_ARENA_HPP
+#define AST_ARENA_HPP
+
+// system includes
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// An AstArena owns the storage of every node built by one parse.
+// Allocation bumps a pointer through large blocks, nothing is freed
+// per node, and all blocks are released together when the arena is
+// destroyed. Objects placed in the arena never have their destructors
+// run, so only trivially destructible data or views may live here
+class AstArena
+{
+public:
+  AstArena() noexcept: cursor(nullptr), remaining(0), used(0){};
+  AstArena(const AstArena &) = delete;
+  AstArena & operator=(const AstArena &) = delete;
+
+  // allocate uninitialized, suitably aligned storage
+  void * allocate(std::size_t bytes, std::size_t alignment);
+
+  // allocate uninitialized storage for count objects of type T
+  template<typename T>
+  T * allocateArray(std::size_t count)
+  {
+    return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // take over the blocks of other, so everything allocated there lives
+  // as long as this arena. other is left empty
+  void adopt(AstArena && other);
+
+  // keep other alive as long as this arena, for nodes here that share
+  // subtrees with nodes there. other must not allocate any more
+  void retain(std::shared_ptr<AstArena> other);
+
+  // bytes handed out so far, including those of retained arenas
+  std::size_t bytesUsed() const noexcept { return used; }
+
+private:
+  // size of a regular block, larger requests get a block of their own
+  static const std::size_t BLOCK_SIZE = 64 * 1024;
+
+  std::vector<std::unique_ptr<unsigned char[]>> blocks;
+  std::vector<std::shared_ptr<AstArena>> retained;
+  unsigned char * cursor;
+  std::size_t remaining;
+  std::size_t used;
+};
+
+#endif
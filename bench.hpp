@@ -0,0 +1,103 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+// Helpers shared by the bench_*.cpp drivers. Each driver is a program of
+// its own, built like the tests against the interpreter sources with
+// optimization on, e.g.
+//   g++ -std=c++17 -O2 -o bench_parse bench_parse.cpp <module sources>
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// module includes
+#include "mapped_file.hpp"
+
+typedef std::chrono::steady_clock BenchClock;
+
+// milliseconds from start to now
+inline double elapsedMs(BenchClock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+inline double median(std::vector<double> samples)
+{
+  std::sort(samples.begin(), samples.end());
+  return samples.empty() ? 0 : samples[samples.size() / 2];
+}
+
+// the most memory the process has held so far in KB, 0 where unknown
+inline long peakRssKb()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+// A (begin ...) script of about bytes bytes that defines numbers and
+// draws lines, one comment per line drawn
+inline std::string generateScript(std::size_t bytes)
+{
+  std::string script = "(begin\n";
+  for (std::size_t i = 0; script.size() < bytes; ++i)
+  {
+    const std::string n = std::to_string(i);
+    script += "  (define v" + n + " (+ (* " + std::to_string(i % 97) + ".5 pi) (- " + std::to_string(i % 13) + " 3)))\n";
+    script += "  (draw (line (point " + std::to_string(i % 50) + " " + std::to_string(i % 70) + ") (point " +
+      std::to_string(i % 31) + " " + std::to_string(i % 11) + "))) ; form " + n + "\n";
+  }
+  script += "  (+ 1 2))\n";
+  return script;
+}
+
+// A (begin ...) script of about bytes bytes with long names and a long
+// comment on each line, where scanning a token runs over many bytes
+inline std::string generateWideScript(std::size_t bytes)
+{
+  std::string script = "(begin\n";
+  for (std::size_t i = 0; script.size() < bytes; ++i)
+  {
+    script += "  (define long_variable_name_" + std::to_string(i) + " (+ another_long_identifier_here " +
+      std::to_string(i * 7919 % 1000003) + ".25))   ;; ";
+    script.append(20 + i * 31 % 60, 'x');
+    script += "\n";
+  }
+  script += "  (+ 1 2))\n";
+  return script;
+}
+
+// The source the drivers run on: the file named on the command line if
+// there is one, otherwise a generated script of defaultBytes bytes
+inline std::string benchSource(int argc, char ** argv, std::size_t defaultBytes)
+{
+  if (argc < 2)
+  {
+    return generateScript(defaultBytes);
+  }
+  MappedFile file(argv[1]);
+  if (!file.isOpen())
+  {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return std::string();
+  }
+  return std::string(file.data());
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Heap allocations made while parsing and evaluating, counted by a
+// replaced operator new: per form of a long program, and per eval() of
+// the programs from the interpreter tests. Usage: bench_alloc [repeats]
+
+// system includes
+#include <cstdlib>
+#include <iterator>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+namespace
+{
+  std::size_t allocations = 0;
+
+  // programs the interpreter tests evaluate
+  const char * const testPrograms[] = {
+    "(begin (define r 10) (* pi (* r r)))",
+    "(+ 1 2 3 4 5 6)",
+    "(if True (4) (-4))",
+    "(define answer 42)",
+    "(begin (define answer (+ 9 11)) (answer))",
+    "(begin (define a 1) (define b 1) (+ a b))",
+    "(+ (+ 10 1) (+ 30 (+ 1 1)))",
+    "(line (point 0 0) (point 10 0))",
+    "(arc (point 0 0) (point 10 0) pi)",
+    "(begin (define r 10) (define big 1e300) (if (< r -2.5) (draw (point 0 0)) (* pi (* r r))))",
+    "(begin (define a #[1 2.5\n -3e2 ]) (+ (nth a 1) (length a)))",
+    "(define a (if (< (* 2 3) 8) (+ 1 (if True 2 3)) 4))",
+    "(begin (define a 1) (define b (+ a 1)) (* b 10))",
+    "(begin (define a 1) (define b 2) (define c 3))",
+  };
+}
+
+void * operator new(std::size_t size)
+{
+  ++allocations;
+  if (void * block = std::malloc(size == 0 ? 1 : size))
+  {
+    return block;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void * block) noexcept
+{
+  std::free(block);
+}
+
+void operator delete(void * block, std::size_t) noexcept
+{
+  std::free(block);
+}
+
+int main(int argc, char ** argv)
+{
+  const int repeats = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+  // Five compound forms per repeat, besides the begin around them
+  std::ostringstream program;
+  program << "(begin (define a 1) (define b 2)";
+  for (int i = 0; i < repeats; ++i)
+  {
+    program << " (+ a b) (point a b) (* a b 3) (+ (* a 2) (- b 1))";
+  }
+  program << ")";
+  const std::string source = program.str();
+  const double forms = 5.0 * repeats;
+
+  Interpreter interp;
+  interp.setParseThreads(1);
+
+  std::size_t before = allocations;
+  BenchClock::time_point start = BenchClock::now();
+  if (!interp.parse(std::string_view(source)))
+  {
+    std::cerr << "The program does not parse." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double parseMs = elapsedMs(start);
+  const std::size_t parseAllocations = allocations - before;
+
+  before = allocations;
+  start = BenchClock::now();
+  interp.eval();
+  const double evalMs = elapsedMs(start);
+  const std::size_t evalAllocations = allocations - before;
+
+  // A short program is read as a single form
+  Interpreter small;
+  before = allocations;
+  for (int i = 0; i < 1000; ++i)
+  {
+    small.parse(std::string_view("(+ (* 1 2) (- 3 1))"));
+  }
+  const std::size_t smallAllocations = allocations - before;
+
+  std::cout << "parse: " << parseAllocations / forms << " allocations per form, " << parseMs << " ms\n"
+            << "eval:  " << evalAllocations / forms << " allocations per form, " << evalMs << " ms\n"
+            << "small parse: " << smallAllocations / 1000.0 << " allocations per call\n"
+            << "eval of the test programs:";
+
+  std::size_t total = 0;
+  for (const char * test : testPrograms)
+  {
+    Interpreter interp;
+    if (!interp.parse(std::string_view(test)))
+    {
+      std::cerr << "\nThe program does not parse: " << test << std::endl;
+      return EXIT_FAILURE;
+    }
+    before = allocations;
+    interp.eval();
+    total += allocations - before;
+    std::cout << " " << allocations - before;
+  }
+  std::cout << " (mean " << static_cast<double>(total) / std::size(testPrograms) << ")" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+// Parse time of deeply nested programs, "(- (- ... 1))", which must not
+// overflow the stack. Usage: bench_deep [depth...], by default 100000
+// and 1000000
+
+// system includes
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+int main(int argc, char ** argv)
+{
+  std::vector<std::size_t> depths;
+  for (int i = 1; i < argc; ++i)
+  {
+    depths.push_back(std::strtoul(argv[i], nullptr, 10));
+  }
+  if (depths.empty())
+  {
+    depths = { 100000, 1000000 };
+  }
+
+  for (std::size_t depth : depths)
+  {
+    std::string source;
+    source.reserve(depth * 5 + 1);
+    for (std::size_t i = 0; i < depth; ++i)
+    {
+      source += "(- ";
+    }
+    source += "1";
+    source.append(depth, ')');
+
+    double parseMs = 0;
+    bool ok = false;
+    BenchClock::time_point start;
+    {
+      Interpreter interp;
+      start = BenchClock::now();
+      ok = interp.parse(std::string_view(source));
+      parseMs = elapsedMs(start);
+      start = BenchClock::now();
+    }
+    const double destroyMs = elapsedMs(start);
+
+    std::cout << "depth " << depth << ": parsed " << (ok ? "yes" : "no") << ", parse " << parseMs
+              << " ms, destroy " << destroyMs << " ms" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
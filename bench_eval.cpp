@@ -0,0 +1,144 @@
+// Eval time of the tree walker against the bytecode VM, on generated
+// programs of arithmetic and of drawing, and the builtin calls each makes
+// per second. Usage: bench_eval [forms]
+
+// system includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "bytecode.hpp"
+#include "interpreter.hpp"
+
+namespace
+{
+  // runs the steps of eval() one at a time
+  class EvalProbe: public Interpreter
+  {
+  public:
+    explicit EvalProbe(const std::string & source)
+    {
+      parse(std::string_view(source));
+      resolveProgram(ast, env, resolved);
+    }
+
+    Expression walk() { return evaluateNode(resolved, resolved.root()); }
+
+    void compile(Bytecode & bytecode) const { compileBytecode(resolved, env, bytecode); }
+
+    Expression run(const Bytecode & bytecode) { return runBytecode(bytecode, env); }
+  };
+
+  std::string arithmetic(int forms)
+  {
+    std::ostringstream program;
+    program << "(begin (define a 3) (define b 4) (define c 5)";
+    for (int i = 0; i < forms; ++i)
+    {
+      program << " (+ (* a 2) (- b (/ c 3)) (if (< a b) (pow a 2) (log10 c)))";
+    }
+    program << ")";
+    return program.str();
+  }
+
+  std::string drawing(int forms)
+  {
+    std::ostringstream program;
+    program << "(begin (define r 3)";
+    for (int i = 0; i < forms; ++i)
+    {
+      program << " (draw (arc (point " << i % 7 << " 0) (point r " << i % 5 << ") (* pi 2))"
+              << " (line (point 0 0) (point r r)))";
+    }
+    program << ")";
+    return program.str();
+  }
+
+  // The best of 5 runs of each way to evaluate source, each in a fresh
+  // interpreter, as a program runs once
+  void measure(const std::string & name, const std::string & source)
+  {
+    double tree = 1e300, vm = 1e300, walk = 1e300, run = 1e300;
+    for (int i = 0; i < 5; ++i)
+    {
+      Interpreter treeInterp;
+      treeInterp.parse(std::string_view(source));
+      BenchClock::time_point start = BenchClock::now();
+      const Expression treeValue = treeInterp.eval();
+      tree = std::min(tree, elapsedMs(start));
+
+      Interpreter vmInterp;
+      vmInterp.setEvaluator(Interpreter::Evaluator::Bytecode);
+      vmInterp.parse(std::string_view(source));
+      start = BenchClock::now();
+      const Expression vmValue = vmInterp.eval();
+      vm = std::min(vm, elapsedMs(start));
+
+      EvalProbe walked(source);
+      start = BenchClock::now();
+      const Expression walkValue = walked.walk();
+      walk = std::min(walk, elapsedMs(start));
+
+      EvalProbe compiled(source);
+      Bytecode bytecode;
+      compiled.compile(bytecode);
+      start = BenchClock::now();
+      const Expression runValue = compiled.run(bytecode);
+      run = std::min(run, elapsedMs(start));
+
+      if (!(treeValue == vmValue) || !(treeValue == walkValue) || !(treeValue == runValue))
+      {
+        std::cerr << name << ": the evaluators disagree" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+    std::cout << name << ": eval() tree " << tree << " ms, vm " << vm << " ms; without resolve and compile, tree "
+              << walk << " ms, vm " << run << " ms" << std::endl;
+  }
+
+  // Builtin calls per second, median of 15 runs over forms repeats of
+  // form, which makes calls calls
+  void measureCalls(const std::string & form, int calls, int forms)
+  {
+    std::string source = "(begin (define a 3) (define b 4)";
+    for (int i = 0; i < forms; ++i)
+    {
+      source += " " + form;
+    }
+    source += ")";
+
+    std::vector<double> walk, run;
+    for (int i = 0; i < 15; ++i)
+    {
+      EvalProbe walked(source);
+      BenchClock::time_point start = BenchClock::now();
+      walked.walk();
+      walk.push_back(elapsedMs(start));
+
+      EvalProbe compiled(source);
+      Bytecode bytecode;
+      compiled.compile(bytecode);
+      start = BenchClock::now();
+      compiled.run(bytecode);
+      run.push_back(elapsedMs(start));
+    }
+    const double made = static_cast<double>(forms) * calls;
+    std::cout << form << ": tree " << made / median(walk) / 1000.0 << " M calls/s, vm "
+              << made / median(run) / 1000.0 << " M calls/s" << std::endl;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  const int forms = argc > 1 ? std::atoi(argv[1]) : 100000;
+  measure("arithmetic", arithmetic(forms));
+  measure("draw", drawing(forms));
+  measureCalls("(+ a b)", 1, forms / 2);
+  measureCalls("(+ (* a 2) (- b 1) (pow a 2))", 4, forms / 2);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+// Eval time with and without folding, on a geometry script computed from
+// constants: the first eval of a program, and repeated evals of it.
+// Usage: bench_fold [groups] [evals]
+
+// system includes
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+namespace
+{
+  // groups of an arc, a line and an if, all computed from r and pi
+  std::string shapes(int groups)
+  {
+    std::ostringstream program;
+    program << "(begin";
+    for (int i = 0; i < groups; ++i)
+    {
+      program << " (draw (arc (point (* r (cos (/ pi " << i % 8 + 1 << "))) (* r (sin (/ pi " << i % 8 + 1
+              << ")))) (point 0 0) (* pi (/ " << i % 5 + 1 << " 4)))"
+              << " (line (point (* 2 r) 0) (point 0 (* pi (* r r))))"
+              << " (if (< (* pi (* r r)) 50) (point r r) (point 0 0)))";
+    }
+    program << ")";
+    return program.str();
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  const int groups = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const int evals = argc > 2 ? std::atoi(argv[2]) : 20;
+  const std::string source = shapes(groups);
+
+  std::cout << std::fixed << std::setprecision(1) << "median of 11, ms  first eval" << std::setw(6) << evals
+            << " evals" << std::endl;
+  for (Interpreter::Evaluator evaluator : { Interpreter::Evaluator::Tree, Interpreter::Evaluator::Bytecode })
+  {
+    for (bool folding : { false, true })
+    {
+      std::vector<double> first, all;
+      for (int run = 0; run < 11; ++run)
+      {
+        // r is bound before the program is parsed, so folding can
+        // replace it by its value
+        Interpreter interp;
+        interp.setEvaluator(evaluator);
+        interp.setFolding(folding);
+        interp.parse(std::string_view("(define r 3)"));
+        interp.eval();
+        interp.parse(std::string_view(source));
+
+        const BenchClock::time_point start = BenchClock::now();
+        interp.eval();
+        first.push_back(elapsedMs(start));
+        for (int i = 1; i < evals; ++i)
+        {
+          interp.eval();
+        }
+        all.push_back(elapsedMs(start));
+      }
+      const std::string name = std::string(evaluator == Interpreter::Evaluator::Tree ? "tree" : "vm") +
+        (folding ? ", folded" : "");
+      std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << median(first)
+                << std::setw(12) << median(all) << std::endl;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+// Hashing and comparing whole programs: the hash of the root, a set of
+// the top level forms, a set of drawing forms whose numbers are all in
+// [-1, 1], deep == of two separate parses, and deep == of a deeply
+// nested program. Usage: bench_hash [file], by default on a generated
+// 10 MB script
+
+// system includes
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+namespace
+{
+  // reads the parsed program
+  class TreeProbe: public Interpreter
+  {
+  public:
+    TreeProbe()
+    {
+      setParseThreads(1);
+    }
+
+    const Expression & tree() const noexcept { return ast; }
+  };
+}
+
+int main(int argc, char ** argv)
+{
+  const std::string source = benchSource(argc, argv, 10 * 1024 * 1024);
+  if (source.empty())
+  {
+    return EXIT_FAILURE;
+  }
+
+  TreeProbe first, second;
+  BenchClock::time_point start = BenchClock::now();
+  if (!first.parse(std::string_view(source)))
+  {
+    std::cerr << "The source does not parse." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const double parseMs = elapsedMs(start);
+  second.parse(std::string_view(source));
+
+  // The sum keeps the hashes from being optimized away
+  const int hashes = 1000000;
+  std::size_t sum = 0;
+  start = BenchClock::now();
+  for (int i = 0; i < hashes; ++i)
+  {
+    sum += std::hash<Expression>()(first.tree());
+  }
+  const double hashNs = elapsedMs(start) * 1e6 / hashes;
+
+  start = BenchClock::now();
+  std::unordered_set<Expression, std::hash<Expression>, IdenticalExpression> forms(
+    first.tree().tail.begin(), first.tree().tail.end());
+  const double setMs = elapsedMs(start);
+
+  // Geometry on the unit circle, as the drawing scripts make it
+  const std::size_t shapes = 200000;
+  std::vector<Expression> drawing;
+  drawing.reserve(shapes);
+  for (std::size_t i = 0; i < shapes; ++i)
+  {
+    const double angle = 0.001 * static_cast<double>(i);
+    const Expression line(std::make_tuple(std::cos(angle), std::sin(angle)),
+                          std::make_tuple(-std::sin(angle), std::cos(angle)));
+    drawing.emplace_back(Symbol("draw"), std::vector<Expression>{ line, Expression(angle / shapes) });
+  }
+  start = BenchClock::now();
+  std::unordered_set<Expression, std::hash<Expression>, IdenticalExpression> small(drawing.begin(), drawing.end());
+  const double smallMs = elapsedMs(start);
+
+  start = BenchClock::now();
+  const bool equal = first.tree() == second.tree();
+  const double equalMs = elapsedMs(start);
+
+  std::string nested;
+  const std::size_t depth = 1000000;
+  for (std::size_t i = 0; i < depth; ++i)
+  {
+    nested += "(- ";
+  }
+  nested += "1";
+  nested.append(depth, ')');
+  TreeProbe deepFirst, deepSecond;
+  deepFirst.parse(std::string_view(nested));
+  deepSecond.parse(std::string_view(nested));
+  start = BenchClock::now();
+  const bool deepEqual = deepFirst.tree() == deepSecond.tree();
+  const double deepMs = elapsedMs(start);
+
+  std::cout << "parse:                    " << parseMs << " ms\n"
+            << "hash of the root:         " << hashNs << " ns (" << (sum != 0) << ")\n"
+            << "set of the forms:         " << setMs << " ms (" << forms.size() << " forms)\n"
+            << "set of small numbers:     " << smallMs << " ms (" << small.size() << " forms)\n"
+            << "deep == of two parses:    " << equalMs << " ms (" << (equal ? "equal" : "different") << ")\n"
+            << "deep == of 1M-deep nests: " << deepMs << " ms (" << (deepEqual ? "equal" : "different") << ")"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+// Lexer throughput: tokens pulled until the end of a script, in MB of
+// source per second, with each block classifier this processor runs
+// and its speed against the scalar one. Usage: bench_lexer [file...],
+// by default on two generated 10 MB scripts, one of short tokens and
+// one of long names and comments
+
+// system includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "char_scan.hpp"
+#include "tokenize.hpp"
+
+namespace
+{
+  // best MB/s of 7 runs with the classifier in use
+  double throughput(const std::string & source, std::size_t & tokens)
+  {
+    double best = 0;
+    for (int run = 0; run < 7; ++run)
+    {
+      const BenchClock::time_point start = BenchClock::now();
+      Lexer lexer(source);
+      tokens = 0;
+      while (!lexer.atEnd())
+      {
+        lexer.next();
+        ++tokens;
+      }
+      best = std::max(best, source.size() / elapsedMs(start) / 1000.0);
+    }
+    return best;
+  }
+
+  // The scalar classifier is the last one, every processor runs it
+  void measure(const std::string & name, const std::string & source)
+  {
+    const std::string initial = scanImplementation();
+    const std::vector<const char *> classifiers = scanImplementations();
+    std::vector<double> best;
+    std::size_t tokens = 0;
+    for (const char * classifier : classifiers)
+    {
+      setScanImplementation(classifier);
+      best.push_back(throughput(source, tokens));
+    }
+    setScanImplementation(initial);
+
+    std::cout << name << ", " << tokens << " tokens (best of 7):\n";
+    for (std::size_t i = 0; i < classifiers.size(); ++i)
+    {
+      std::cout << "  " << classifiers[i] << ": " << best[i] << " MB/s, " << best[i] / best.back() << "x scalar\n";
+    }
+    std::cout << std::flush;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  if (argc < 2)
+  {
+    measure("short tokens", generateScript(10 * 1024 * 1024));
+    measure("long names and comments", generateWideScript(10 * 1024 * 1024));
+    return EXIT_SUCCESS;
+  }
+
+  for (int i = 1; i < argc; ++i)
+  {
+    MappedFile file(argv[i]);
+    if (!file.isOpen())
+    {
+      std::cerr << "Cannot open " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+    measure(argv[i], std::string(file.data()));
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+// Tokens converted per second by token_to_atom, on a mix of symbols and
+// numbers and on numbers alone. Usage: bench_number [tokens]
+
+// system includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "expression.hpp"
+
+namespace
+{
+  // the best of runs passes over count tokens taken in turn from tokens,
+  // in millions per second
+  double tokensPerSecond(const std::vector<std::string_view> & tokens, std::size_t count, int runs)
+  {
+    double best = 0;
+    for (int run = 0; run < runs; ++run)
+    {
+      std::size_t converted = 0;
+      const BenchClock::time_point start = BenchClock::now();
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        Atom atom;
+        converted += token_to_atom(tokens[i % tokens.size()], atom);
+      }
+      const double ms = elapsedMs(start);
+      if (converted == 0)
+      {
+        return 0;
+      }
+      best = std::max(best, count / ms / 1000.0);
+    }
+    return best;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+  // Most tokens of a program are names, which must be told apart from
+  // numbers before they become symbols
+  const std::vector<std::string_view> mixed = { "define", "+", "x", "point", "12.5", "-3", "pi", "r",
+    "line", "1e4", "draw", "*", "arc", "42", "0x1p3" };
+  const std::vector<std::string_view> numbers = { "12.5", "-3", "1e4", "42", "0.001", "-7.25e-3",
+    "1e308", "0x1f", "3.14159265358979", "+6" };
+
+  std::cout << "mixed tokens:   " << tokensPerSecond(mixed, count, 5) << " M/s\n"
+            << "number tokens:  " << tokensPerSecond(numbers, count, 5) << " M/s" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+// Parse time and memory of one Interpreter::parse of a large script: the
+// peak memory and the bytes of AST nodes in the arena.
+// Usage: bench_parse [file], by default on a generated 10 MB script
+
+// system includes
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+namespace
+{
+  // reads the arena the program was parsed into
+  class ArenaProbe: public Interpreter
+  {
+  public:
+    std::size_t arenaBytes() const noexcept { return astArena ? astArena->bytesUsed() : 0; }
+  };
+}
+
+int main(int argc, char ** argv)
+{
+  const std::string source = benchSource(argc, argv, 10 * 1024 * 1024);
+  if (source.empty())
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Threads would parse the program in parts, so they are off to time
+  // the parser alone
+  ArenaProbe interp;
+  interp.setParseThreads(1);
+
+  std::istringstream stream(source);
+  const long rssBefore = peakRssKb();
+  const BenchClock::time_point start = BenchClock::now();
+  const bool ok = interp.parse(stream);
+  const double parseMs = elapsedMs(start);
+
+  std::cout << "source:        " << source.size() / (1024.0 * 1024.0) << " MB\n"
+            << "parsed:        " << (ok ? "yes" : "no") << "\n"
+            << "parse:         " << parseMs << " ms\n"
+            << "peak RSS grew: " << (peakRssKb() - rssBefore) / 1024.0 << " MB\n"
+            << "arena:         " << interp.arenaBytes() / (1024.0 * 1024.0) << " MB\n"
+            << "sizeof(Atom) " << sizeof(Atom) << ", sizeof(Expression) " << sizeof(Expression) << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,64 @@
+// Startup from source against startup from a compiled .slc program.
+// Usage: bench_slc [file], by default on a generated 10 MB script
+
+// system includes
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// module includes
+#include "bench.hpp"
+#include "interpreter.hpp"
+
+int main(int argc, char ** argv)
+{
+  const std::string source = benchSource(argc, argv, 10 * 1024 * 1024);
+  if (source.empty())
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::string image;
+  {
+    Interpreter interp;
+    if (!interp.parse(std::string_view(source)))
+    {
+      std::cerr << "The source does not parse." << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::ostringstream out;
+    interp.saveProgram(out);
+    image = out.str();
+  }
+
+  // Both read from memory, so neither pays for the disk
+  std::vector<double> parseMs, loadMs;
+  for (int run = 0; run < 5; ++run)
+  {
+    {
+      Interpreter interp;
+      interp.setParseThreads(1);
+      const BenchClock::time_point start = BenchClock::now();
+      interp.parse(std::string_view(source));
+      parseMs.push_back(elapsedMs(start));
+    }
+    {
+      Interpreter interp;
+      const BenchClock::time_point start = BenchClock::now();
+      if (!interp.loadProgram(std::string_view(image)))
+      {
+        std::cerr << "The compiled program does not load." << std::endl;
+        return EXIT_FAILURE;
+      }
+      loadMs.push_back(elapsedMs(start));
+    }
+  }
+
+  std::cout << "source " << source.size() / (1024.0 * 1024.0) << " MB, .slc " << image.size() / (1024.0 * 1024.0)
+            << " MB (median of 5)\n"
+            << "parse source: " << median(parseMs) << " ms\n"
+            << "load .slc:    " << median(loadMs) << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
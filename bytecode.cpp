@@ -0,0 +1,334 @@
+#include "bytecode.hpp"
+
+// system includes
+#include <utility>
+
+// module includes
+#include "interpreter_semantic_error.hpp"
+
+namespace
+{
+  class Compiler
+  {
+  public:
+    Compiler(const ResolvedProgram & program, const Environment & env, Bytecode & out):
+      program(program), env(env), out(out){};
+
+    // Compile the program below root. Open nodes are kept on an explicit
+    // stack instead of the call stack, as in the resolver, so any program
+    // that can be resolved can be compiled. Each open node is compiled a
+    // step at a time, one step before each of its children and one after
+    // the last
+    void compile(const ResolvedNode & root)
+    {
+      open.clear();
+      enter(root);
+      while (!open.empty())
+      {
+        // Entering a child can move the stack, so the step is taken first
+        Open & top = open.back();
+        const ResolvedNode & node = *top.node;
+        const std::uint32_t step = top.step++;
+
+        switch (node.form)
+        {
+        case Form::If:
+          if (step == 0)
+          {
+            enter(program.child(node, 0));
+          }
+          else if (step == 1)
+          {
+            top.jump = emit(OpCode::JumpIfFalse, 0, 0, -1);
+            enter(program.child(node, 1));
+          }
+          else if (step == 2)
+          {
+            const std::size_t toElse = top.jump;
+            top.jump = emit(OpCode::Jump, 0, 0, -1);
+            out.code[toElse].operand = here();
+            enter(program.child(node, 2));
+          }
+          else
+          {
+            out.code[top.jump].operand = here();
+            open.pop_back();
+          }
+          break;
+
+        case Form::Begin:
+          if (step < node.children.count)
+          {
+            if (step > 0)
+            {
+              emit(OpCode::Pop, 0, 0, -1);
+            }
+            enter(program.child(node, step));
+          }
+          else
+          {
+            open.pop_back();
+          }
+          break;
+
+        case Form::Define:
+          if (step == 0)
+          {
+            enter(program.child(node, 1));
+          }
+          else
+          {
+            emit(OpCode::Define, 0, node.operand, 0);
+
+            // Code only ever jumps forward, so calls compiled before this point
+            // run before the definition. Later calls to the name, which may no
+            // longer be a builtin, look it up when they are made
+            known(node.operand) = DEFINED;
+            open.pop_back();
+          }
+          break;
+
+        case Form::Call:
+          // A procedure call, its arguments are evaluated first
+          if (step < node.children.count)
+          {
+            enter(program.child(node, step));
+          }
+          else
+          {
+            const int change = 1 - static_cast<int>(node.children.count);
+            const std::uint32_t proc = procedure(node.operand);
+            if (proc != DEFINED)
+            {
+              emit(OpCode::Call, node.children.count, proc, change);
+            }
+            else
+            {
+              emit(OpCode::CallSlot, node.children.count, node.operand, change);
+            }
+            open.pop_back();
+          }
+          break;
+
+        default:
+          open.pop_back();
+          break;
+        }
+      }
+    }
+
+    void finish()
+    {
+      emit(OpCode::Return, 0, 0, 0);
+    }
+
+  private:
+    // A node whose children are being compiled, the step it is at, and
+    // the jump of an If still to be patched
+    struct Open
+    {
+      const ResolvedNode * node;
+      std::uint32_t step;
+      std::size_t jump;
+    };
+
+    // compile what comes before the children of node, or all of it if
+    // it has none
+    void enter(const ResolvedNode & node)
+    {
+      switch (node.form)
+      {
+      case Form::Constant:
+        out.constants.push_back(node.constant->head);
+        emit(OpCode::Constant, 0, static_cast<std::uint32_t>(out.constants.size() - 1), 1);
+        return;
+
+      case Form::Variable:
+        emit(OpCode::Load, 0, node.operand, 1);
+        return;
+
+      case Form::Define:
+        emit(OpCode::CheckDefine, 0, node.operand, 0);
+        open.push_back({ &node, 0, 0 });
+        return;
+
+      case Form::DefineReserved:
+        emit(OpCode::CheckDefine, 0, node.operand, 0);
+        raise(DEFINE_RESERVED);
+        return;
+
+      case Form::If:
+      case Form::Begin:
+      case Form::Call:
+        open.push_back({ &node, 0, 0 });
+        return;
+
+      case Form::Invalid:
+        break;
+      }
+      raise(static_cast<ResolveError>(node.operand));
+    }
+
+    std::size_t emit(OpCode op, std::uint32_t count, std::uint32_t operand, int change)
+    {
+      out.code.push_back({ op, count, operand });
+      height += change;
+      if (height > out.maxStack)
+      {
+        out.maxStack = height;
+      }
+      return out.code.size() - 1;
+    }
+
+    // A Raise stands in for the value its expression would have had
+    void raise(ResolveError error)
+    {
+      emit(OpCode::Raise, 0, error, 1);
+    }
+
+    std::uint32_t here() const noexcept
+    {
+      return static_cast<std::uint32_t>(out.code.size());
+    }
+
+    // What is known about the procedure in each slot: its index in the
+    // procedure pool, UNKNOWN before it is looked up, or DEFINED if it is
+    // not a builtin or the program has defined the name by now
+    static constexpr std::uint32_t UNKNOWN = ~std::uint32_t(0);
+    static constexpr std::uint32_t DEFINED = UNKNOWN - 1;
+
+    std::uint32_t & known(Environment::Slot slot)
+    {
+      if (slot >= procedures.size())
+      {
+        procedures.resize(slot + 1, UNKNOWN);
+      }
+      return procedures[slot];
+    }
+
+    std::uint32_t procedure(Environment::Slot slot)
+    {
+      std::uint32_t & index = known(slot);
+      if (index == UNKNOWN)
+      {
+        index = DEFINED;
+        const Environment::Callee proc = env.callee(slot);
+        if (proc.proc != nullptr)
+        {
+          index = static_cast<std::uint32_t>(out.procedures.size());
+          out.procedures.push_back(proc);
+        }
+      }
+      return index;
+    }
+
+    const ResolvedProgram & program;
+    const Environment & env;
+    Bytecode & out;
+    std::size_t height = 0;
+    std::vector<std::uint32_t> procedures;
+    std::vector<Open> open;
+  };
+}
+
+void Bytecode::clear() noexcept
+{
+  code.clear();
+  constants.clear();
+  procedures.clear();
+  maxStack = 0;
+}
+
+void compileBytecode(const ResolvedProgram & program, const Environment & env, Bytecode & bytecode)
+{
+  bytecode.clear();
+  Compiler compiler(program, env, bytecode);
+  compiler.compile(program.root());
+  compiler.finish();
+}
+
+Expression runBytecode(const Bytecode & bytecode, Environment & env)
+{
+  // Every value is an atom, so the stack holds atoms and the arguments
+  // of a call are a run of them procedures can take in place
+  std::vector<Atom> stack;
+  stack.reserve(bytecode.maxStack);
+
+  const Instruction * code = bytecode.code.data();
+  std::size_t pc = 0;
+  while (true)
+  {
+    const Instruction & instruction = code[pc++];
+    switch (instruction.op)
+    {
+    case OpCode::Constant:
+      stack.push_back(bytecode.constants[instruction.operand]);
+      break;
+    case OpCode::Load:
+    {
+      const Expression * value = env.lookup(instruction.operand);
+      if (value == nullptr)
+      {
+        // get fails with the error for a name bound to no expression
+        env.get(instruction.operand);
+      }
+      stack.push_back(value->head);
+      break;
+    }
+    case OpCode::Pop:
+      stack.pop_back();
+      break;
+    case OpCode::JumpIfFalse:
+    {
+      const Atom & condition = stack.back();
+      if (condition.type != BooleanType)
+      {
+        throw InterpreterSemanticError("Error: Conditional in 'if' is not a boolean.");
+      }
+      const bool value = condition.value.bool_value;
+      stack.pop_back();
+      if (!value)
+      {
+        pc = instruction.operand;
+      }
+      break;
+    }
+    case OpCode::Jump:
+      pc = instruction.operand;
+      break;
+    case OpCode::CheckDefine:
+      if (env.lookup(instruction.operand) != nullptr)
+      {
+        throw InterpreterSemanticError("Error: Variable already exists");
+      }
+      break;
+    case OpCode::Define:
+      // the value left on the stack is the one the environment keeps,
+      // so an array refers to the copy of its numbers the binding owns
+      env.addSymbol(instruction.operand, Expression(stack.back()));
+      stack.back() = env.lookup(instruction.operand)->head;
+      break;
+    case OpCode::Call:
+    case OpCode::CallSlot:
+    {
+      const std::size_t first = stack.size() - instruction.count;
+      Atom result;
+      if (instruction.op == OpCode::Call)
+      {
+        env.apply(bytecode.procedures[instruction.operand], stack.data() + first, instruction.count, result);
+      }
+      else
+      {
+        env.evaluateProcedure(instruction.operand, stack.data() + first, instruction.count, result);
+      }
+      stack.resize(first);
+      stack.push_back(result);
+      break;
+    }
+    case OpCode::Raise:
+      throw InterpreterSemanticError(resolveErrorMessage(instruction.operand));
+    case OpCode::Return:
+      return Expression(stack.back());
+    }
+  }
+}
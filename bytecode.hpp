@@ -0,0 +1,67 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+#include "environment.hpp"
+#include "resolver.hpp"
+
+// The operations of the bytecode VM. The operand of an instruction
+// indexes one of the pools of its Bytecode, is an environment slot, or
+// is a jump target
+enum class OpCode : std::uint8_t
+{
+  Constant,    // push constants[operand]
+  Load,        // push the expression bound to slot operand
+  Pop,         // drop the top value
+  JumpIfFalse, // pop a Boolean condition, jump to operand if it is False
+  Jump,        // jump to operand
+  CheckDefine, // fail if slot operand is bound to an expression
+  Define,      // bind slot operand to the top value, which stays
+  Call,        // replace the top count values by procedures[operand] of them
+  CallSlot,    // the same for the procedure bound to slot operand
+  Raise,       // fail with the error numbered operand
+  Return       // the top value is the value of the program
+};
+
+struct Instruction
+{
+  OpCode op;
+  std::uint32_t count;
+  std::uint32_t operand;
+};
+
+// A program lowered to bytecode for a stack machine. Literals are in a
+// constant pool, names are the slots they were resolved to, and calls to
+// builtins the program has not redefined by then refer straight to the
+// procedure. Constants refer to the arena of the AST they came from,
+// like the AST
+class Bytecode
+{
+public:
+  std::vector<Instruction> code;
+  std::vector<Atom> constants;
+  std::vector<Environment::Callee> procedures;
+
+  // the most values on the stack at once
+  std::size_t maxStack = 0;
+
+  void clear() noexcept;
+};
+
+// Lower a program resolved against env to bytecode, looking builtins up
+// in env. The program is walked without recursion, so any nesting the
+// resolver accepts can be compiled
+void compileBytecode(const ResolvedProgram & program, const Environment & env, Bytecode & bytecode);
+
+// run bytecode against env and return the value of the program. Errors
+// are raised in the same order and with the same messages as
+// Interpreter::evaluateExpression
+Expression runBytecode(const Bytecode & bytecode, Environment & env);
+
+#endif
@@ -0,0 +1,263 @@
+#include "char_scan.hpp"
+
+// system includes
+#include <atomic>
+#include <cstring>
+
+// module includes
+#include "tokenize.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHAR_SCAN_SSE2 1
+#endif
+
+#if defined(CHAR_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CHAR_SCAN_AVX2 1
+#endif
+
+namespace
+{
+  const std::size_t BLOCK = 64;
+
+  // Byte classes for the scalar classifier
+  const unsigned char SPACE = 1;
+  const unsigned char DELIMITER = 2;
+
+  struct ClassTable
+  {
+    unsigned char classes[256] = {};
+
+    ClassTable()
+    {
+      for (const char c : { ' ', '\t', '\n', '\v', '\f', '\r' })
+      {
+        classes[static_cast<unsigned char>(c)] = SPACE | DELIMITER;
+      }
+      for (const char c : { OPEN, CLOSE, COMMENT })
+      {
+        classes[static_cast<unsigned char>(c)] = DELIMITER;
+      }
+    }
+  };
+
+  const ClassTable table;
+
+  // A classifier sets bit i of spaces and delimiters for byte i of a
+  // 64 byte block
+  typedef void (*Classifier)(const char * block, std::uint64_t & spaces, std::uint64_t & delimiters);
+
+  void classifyScalar(const char * block, std::uint64_t & spaces, std::uint64_t & delimiters)
+  {
+    spaces = 0;
+    delimiters = 0;
+    for (std::size_t i = 0; i < BLOCK; ++i)
+    {
+      const unsigned char c = table.classes[static_cast<unsigned char>(block[i])];
+      spaces |= static_cast<std::uint64_t>(c & SPACE) << i;
+      delimiters |= static_cast<std::uint64_t>((c & DELIMITER) >> 1) << i;
+    }
+  }
+
+#ifdef CHAR_SCAN_SSE2
+  void classifySSE2(const char * block, std::uint64_t & spaces, std::uint64_t & delimiters)
+  {
+    spaces = 0;
+    delimiters = 0;
+    for (std::size_t i = 0; i < BLOCK; i += 16)
+    {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+
+      // Whitespace is ' ' or '\t'..'\r', the range test is an unsigned min
+      const __m128i controls = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+      const __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(controls, _mm_set1_epi8('\r' - '\t')), controls);
+      const __m128i space = _mm_or_si128(inRange, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+
+      const __m128i parens = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(OPEN)), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(CLOSE)));
+      const __m128i delimiter = _mm_or_si128(_mm_or_si128(parens, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(COMMENT))), space);
+
+      spaces |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(space))) << i;
+      delimiters |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(delimiter))) << i;
+    }
+  }
+#endif
+
+#ifdef CHAR_SCAN_AVX2
+  __attribute__((target("avx2"))) void classifyAVX2(const char * block, std::uint64_t & spaces, std::uint64_t & delimiters)
+  {
+    spaces = 0;
+    delimiters = 0;
+    for (std::size_t i = 0; i < BLOCK; i += 32)
+    {
+      const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+
+      const __m256i controls = _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t'));
+      const __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(controls, _mm256_set1_epi8('\r' - '\t')), controls);
+      const __m256i space = _mm256_or_si256(inRange, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+
+      const __m256i parens = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(OPEN)), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(CLOSE)));
+      const __m256i delimiter = _mm256_or_si256(_mm256_or_si256(parens, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(COMMENT))), space);
+
+      spaces |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(space))) << i;
+      delimiters |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(delimiter))) << i;
+    }
+  }
+#endif
+
+  struct Implementation
+  {
+    Classifier classify;
+    const char * name;
+  };
+
+  // The classifiers this processor runs, fastest first
+  std::vector<Implementation> detect()
+  {
+    std::vector<Implementation> found;
+#ifdef CHAR_SCAN_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+      found.push_back({ classifyAVX2, "avx2" });
+    }
+#endif
+#ifdef CHAR_SCAN_SSE2
+    found.push_back({ classifySSE2, "sse2" });
+#endif
+    found.push_back({ classifyScalar, "scalar" });
+    return found;
+  }
+
+  const std::vector<Implementation> & implementations()
+  {
+    static const std::vector<Implementation> all = detect();
+    return all;
+  }
+
+  // The fastest is chosen on first use, unless one is set
+  std::atomic<const Implementation *> & active()
+  {
+    static std::atomic<const Implementation *> chosen(&implementations().front());
+    return chosen;
+  }
+
+  // Index of the lowest set bit of a non-zero mask
+  inline unsigned lowestBit(std::uint64_t mask)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned i = 0;
+    while ((mask & 1u) == 0)
+    {
+      mask >>= 1;
+      ++i;
+    }
+    return i;
+#endif
+  }
+}
+
+CharScanner::CharScanner(std::string_view text) noexcept
+  : classifier(active().load(std::memory_order_relaxed)->classify),
+    data(text.data()), size(text.size()), blockStart(text.size()), spaces(0), delimiters(0)
+{
+}
+
+// Classify the block holding pos. The last block of the text is copied
+// into a buffer padded with zero bytes, which are neither whitespace nor
+// delimiters, so the classifiers never read past the text
+void CharScanner::classify(std::size_t pos) noexcept
+{
+  blockStart = pos - pos % BLOCK;
+  if (blockStart + BLOCK <= size)
+  {
+    classifier(data + blockStart, spaces, delimiters);
+  }
+  else
+  {
+    char padded[BLOCK] = {};
+    std::memcpy(padded, data + blockStart, size - blockStart);
+    classifier(padded, spaces, delimiters);
+  }
+}
+
+std::size_t CharScanner::skipWhitespace(std::size_t pos) noexcept
+{
+  while (pos < size)
+  {
+    if (pos < blockStart || pos >= blockStart + BLOCK)
+    {
+      classify(pos);
+    }
+
+    const std::uint64_t others = ~spaces >> (pos - blockStart);
+    if (others != 0)
+    {
+      const std::size_t found = pos + lowestBit(others);
+      return found < size ? found : size;
+    }
+    pos = blockStart + BLOCK;
+  }
+  return size;
+}
+
+std::size_t CharScanner::findDelimiter(std::size_t pos) noexcept
+{
+  while (pos < size)
+  {
+    if (pos < blockStart || pos >= blockStart + BLOCK)
+    {
+      classify(pos);
+    }
+
+    const std::uint64_t found = delimiters >> (pos - blockStart);
+    if (found != 0)
+    {
+      return pos + lowestBit(found);
+    }
+    pos = blockStart + BLOCK;
+  }
+  return size;
+}
+
+std::size_t CharScanner::findNewline(std::size_t pos) const noexcept
+{
+  if (pos >= size)
+  {
+    return size;
+  }
+
+  // memchr is already vectorized by the C library
+  const void * newline = std::memchr(data + pos, '\n', size - pos);
+  return newline == nullptr ? size : static_cast<std::size_t>(static_cast<const char *>(newline) - data);
+}
+
+const char * scanImplementation()
+{
+  return active().load(std::memory_order_relaxed)->name;
+}
+
+std::vector<const char *> scanImplementations()
+{
+  std::vector<const char *> names;
+  for (const Implementation & each : implementations())
+  {
+    names.push_back(each.name);
+  }
+  return names;
+}
+
+bool setScanImplementation(std::string_view name)
+{
+  for (const Implementation & each : implementations())
+  {
+    if (name == each.name)
+    {
+      active().store(&each, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,55 @@
+#ifndef CHAR_SCAN_HPP
+#define CHAR_SCAN_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A CharScanner finds token boundaries in source text for the lexer.
+// The delimiters are OPEN, CLOSE, COMMENT and the whitespace characters
+// of the "C" locale. Text is classified 64 bytes at a time into bit
+// masks of whitespace and delimiter positions, so each byte is looked
+// at once and every boundary inside a block is a bit scan. Blocks are
+// classified with AVX2 or SSE2, picked at run time, or with a scalar
+// table on other processors. A scanner keeps the classifier in use when
+// it is made
+class CharScanner
+{
+public:
+  explicit CharScanner(std::string_view text) noexcept;
+
+  // position of the first byte at or after pos that is not whitespace,
+  // or the size of the text if there is none
+  std::size_t skipWhitespace(std::size_t pos) noexcept;
+
+  // position of the first delimiter at or after pos, or the size
+  std::size_t findDelimiter(std::size_t pos) noexcept;
+
+  // position of the first newline at or after pos, or the size
+  std::size_t findNewline(std::size_t pos) const noexcept;
+
+private:
+  void classify(std::size_t pos) noexcept;
+
+  void (*classifier)(const char * block, std::uint64_t & spaces, std::uint64_t & delimiters);
+  const char * data;
+  std::size_t size;
+  std::size_t blockStart;
+  std::uint64_t spaces;
+  std::uint64_t delimiters;
+};
+
+// the block classifier in use: "avx2", "sse2" or "scalar"
+const char * scanImplementation();
+
+// the block classifiers this processor can run, fastest first
+std::vector<const char *> scanImplementations();
+
+// Use the named classifier in the scanners made from now on, so tests
+// and benchmarks can compare them. Returns false, and changes nothing,
+// if this processor cannot run it
+bool setScanImplementation(std::string_view name);
+
+#endif
@@ -2,21 +2,58 @@
 
 #include <cassert>
 #include <cmath>
+#include <algorithm>
 
 #include "interpreter_semantic_error.hpp"
 
+// Names the draw procedure looks for, interned once
+static const Symbol POINT_SYMBOL("point");
+static const Symbol LINE_SYMBOL("line");
+static const Symbol ARC_SYMBOL("arc");
+
+// Procedures write their value to the result they are given
+static void setResult(Atom& result, Boolean value)
+{
+    result.type = BooleanType;
+    result.value.bool_value = value;
+}
+
+static void setResult(Atom& result, Number value)
+{
+    result.type = NumberType;
+    result.value.num_value = value;
+}
+
+static void setResult(Atom& result, const Point& value)
+{
+    result.type = PointType;
+    result.value.point_value = value;
+}
+
+static void setResult(Atom& result, const Line& value)
+{
+    result.type = LineType;
+    result.value.line_value = value;
+}
+
+static void setResult(Atom& result, const Arc& value)
+{
+    result.type = ArcType;
+    result.value.arc_value = value;
+}
+
 //Functon that handles a logical negation procedure
-Expression notProcedure(const std::vector<Atom>& args)
+void notProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 1 || args[0].type != BooleanType)
     {
         throw InterpreterSemanticError("Error: Invalid argument for not");
     }
-    return Expression(!args[0].value.bool_value);
+    setResult(result, !args[0].value.bool_value);
 }
 
 //Functon that handles a logical AND procedure
-Expression andProcedure(const std::vector<Atom>& args)
+void andProcedure(Arguments args, Atom& result)
 {
     if (args.size() < 2)
     {
@@ -34,14 +71,15 @@ Expression andProcedure(const std::vector<Atom>& args)
     {
         if (!arg.value.bool_value)
         {
-            return Expression(false);
+            setResult(result, false);
+            return;
         }
     }
-    return Expression(true);
+    setResult(result, true);
 }
 
 //Functon that handles a logical OR procedure
-Expression orProcedure(const std::vector<Atom>& args)
+void orProcedure(Arguments args, Atom& result)
 {
     if (args.size() < 2)
     {
@@ -59,15 +97,16 @@ Expression orProcedure(const std::vector<Atom>& args)
     {
         if (arg.value.bool_value)
         {
-            return Expression(true);
+            setResult(result, true);
+            return;
         }
     }
 
-    return Expression(false);
+    setResult(result, false);
 }
 
 //Functon that handles an arithmetic add procedure
-Expression ADDProcedure(const std::vector<Atom>& args)
+void ADDProcedure(Arguments args, Atom& result)
 {
     double sum = 0.0;
     for (const auto& arg : args)
@@ -78,11 +117,11 @@ Expression ADDProcedure(const std::vector<Atom>& args)
         }
         sum += arg.value.num_value;
     }
-    return Expression(sum);
+    setResult(result, sum);
 }
 
 //Functon that handles an arithmetic subtract procedure
-Expression subtractProcedure(const std::vector<Atom>& args)
+void subtractProcedure(Arguments args, Atom& result)
 {
     //Unary minus sign
     if (args.size() == 1)
@@ -91,7 +130,8 @@ Expression subtractProcedure(const std::vector<Atom>& args)
         {
             throw InterpreterSemanticError("Error: Invalid argument for unary subtraction");
         }
-        return Expression(-args[0].value.num_value);
+        setResult(result, -args[0].value.num_value);
+        return;
     }
 
     //Binary Subtraction 
@@ -101,14 +141,15 @@ Expression subtractProcedure(const std::vector<Atom>& args)
         {
             throw InterpreterSemanticError("Error: Invalid arguments for binary subtraction");
         }
-        return Expression(args[0].value.num_value - args[1].value.num_value);
+        setResult(result, args[0].value.num_value - args[1].value.num_value);
+        return;
     }
 
     throw InterpreterSemanticError("Error: Invalid number of arguments for subtraction");
 }
 
 //Functon that handles an arithmetic multiply procedure
-Expression multiplyProcedure(const std::vector<Atom>& args)
+void multiplyProcedure(Arguments args, Atom& result)
 {
     if (args.size() < 2)
     {
@@ -124,71 +165,71 @@ Expression multiplyProcedure(const std::vector<Atom>& args)
         }
         product *= arg.value.num_value;
     }
-    return Expression(product);
+    setResult(result, product);
 }
 
 //Functon that handles an arithmetic divide procedure
-Expression divideProcedure(const std::vector<Atom>& args)
+void divideProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType || args[1].value.num_value == 0)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for division");
     }
-    return Expression(args[0].value.num_value / args[1].value.num_value);
+    setResult(result, args[0].value.num_value / args[1].value.num_value);
 }
 
 //Functon that handles a less than comparison procedure
-Expression lessThanProcedure(const std::vector<Atom>& args)
+void lessThanProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for < operation");
     }
-    return Expression(args[0].value.num_value < args[1].value.num_value);
+    setResult(result, args[0].value.num_value < args[1].value.num_value);
 }
 
 //Functon that handles a less than or equal procedure
-Expression lessThanOrEqualProcedure(const std::vector<Atom>& args)
+void lessThanOrEqualProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for <= operation");
     }
-    return Expression(args[0].value.num_value <= args[1].value.num_value);
+    setResult(result, args[0].value.num_value <= args[1].value.num_value);
 }
 
 //Functon that handles a greater than comparison procedure
-Expression greaterThanProcedure(const std::vector<Atom>& args)
+void greaterThanProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for > operation");
     }
-    return Expression(args[0].value.num_value > args[1].value.num_value);
+    setResult(result, args[0].value.num_value > args[1].value.num_value);
 }
 
 //Functon that handles a greater than or equal comparison procedure
-Expression greaterThanOrEqualProcedure(const std::vector<Atom>& args)
+void greaterThanOrEqualProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for >= operation");
     }
-    return Expression(args[0].value.num_value >= args[1].value.num_value);
+    setResult(result, args[0].value.num_value >= args[1].value.num_value);
 }
 
 //Functon that handles an equal comparison procedure
-Expression equalProcedure(const std::vector<Atom>& args)
+void equalProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for = operation");
     }
-    return Expression(args[0].value.num_value == args[1].value.num_value);
+    setResult(result, args[0].value.num_value == args[1].value.num_value);
 }
 
 //Functon that handles an arithmetic logarithmic procedure
-Expression log10Procedure(const std::vector<Atom>& args)
+void log10Procedure(Arguments args, Atom& result)
 {
     if (args.size() != 1 || args[0].type != NumberType)
     {
@@ -198,30 +239,57 @@ Expression log10Procedure(const std::vector<Atom>& args)
     {
         throw InterpreterSemanticError("Error: Non-positive argument for log10");
     }
-    return Expression(std::log10(args[0].value.num_value));
+    setResult(result, std::log10(args[0].value.num_value));
 }
 
 //Functon that handles an arithmetic power procedure
-Expression powProcedure(const std::vector<Atom>& args)
+void powProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType)
     {
         throw InterpreterSemanticError("Error: Invalid arguments for pow operation");
     }
-    return Expression(std::pow(args[0].value.num_value, args[1].value.num_value));
+    setResult(result, std::pow(args[0].value.num_value, args[1].value.num_value));
+}
+
+//Functon that handles the length of an array
+void lengthProcedure(Arguments args, Atom& result)
+{
+    if (args.size() != 1 || args[0].type != ArrayType)
+    {
+        throw InterpreterSemanticError("Error: Invalid arguments for length, expected an array.");
+    }
+    setResult(result, static_cast<double>(args[0].value.array_value.size));
+}
+
+//Functon that handles indexing into an array, counting from 0
+void nthProcedure(Arguments args, Atom& result)
+{
+    if (args.size() != 2 || args[0].type != ArrayType || args[1].type != NumberType)
+    {
+        throw InterpreterSemanticError("Error: Invalid arguments for nth, expected an array and an index.");
+    }
+
+    const Array & array = args[0].value.array_value;
+    const double index = args[1].value.num_value;
+    if (!(index >= 0) || index >= static_cast<double>(array.size) || index != std::floor(index))
+    {
+        throw InterpreterSemanticError("Error: Index out of range for nth.");
+    }
+    setResult(result, array.data[static_cast<std::size_t>(index)]);
 }
 
 // Procedure to create a point
-Expression pointProcedure(const std::vector<Atom>& args) 
+void pointProcedure(Arguments args, Atom& result) 
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType) 
     {
         throw InterpreterSemanticError("Error: Invalid number of arguments for point, expected 2.");
     }
-    return Expression(std::make_tuple(args[0].value.num_value, args[1].value.num_value));
+    setResult(result, Point{ args[0].value.num_value, args[1].value.num_value });
 }
 //Procedure to create a line
-Expression lineProcedure(const std::vector<Atom>& args)
+void lineProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 2 || args[0].type != PointType || args[1].type != PointType)
     {
@@ -233,12 +301,12 @@ Expression lineProcedure(const std::vector<Atom>& args)
     Point endPoint = args[1].value.point_value;
 
     // Create a Line object using the two points
-    return Expression(std::make_tuple(startPoint.x, startPoint.y), std::make_tuple(endPoint.x, endPoint.y));
+    setResult(result, Line{ startPoint, endPoint });
 }
 
 
 //Procedure to create arc
-Expression arcProcedure(const std::vector<Atom>& args)
+void arcProcedure(Arguments args, Atom& result)
 {
     if (args.size() != 3 || args[0].type != PointType || args[1].type != PointType || args[2].type != NumberType)
     {
@@ -251,42 +319,42 @@ Expression arcProcedure(const std::vector<Atom>& args)
     double angle = args[2].value.num_value;
 
     // Create an Arc object using the two points and the angle
-    return Expression(std::make_tuple(centerPoint.x, centerPoint.y), std::make_tuple(startPoint.x, startPoint.y), angle);
+    setResult(result, Arc{ centerPoint, startPoint, angle });
 }
 
 
 
 // Procedure for sin function
-Expression sinProcedure(const std::vector<Atom>& args) 
+void sinProcedure(Arguments args, Atom& result) 
 {
     if (args.size() != 1 || args[0].type != NumberType) 
     {
         throw InterpreterSemanticError("Error: Invalid number of arguments for sin, expected 1.");
     }
-    return Expression(std::sin(args[0].value.num_value));
+    setResult(result, std::sin(args[0].value.num_value));
 }
 
 // Procedure for cos function
-Expression cosProcedure(const std::vector<Atom>& args) 
+void cosProcedure(Arguments args, Atom& result) 
 {
     if (args.size() != 1 || args[0].type != NumberType) 
     {
         throw InterpreterSemanticError("Error: Invalid number of arguments for cos, expected 1.");
     }
-    return Expression(std::cos(args[0].value.num_value));
+    setResult(result, std::cos(args[0].value.num_value));
 }
 
 // Procedure for arctan function
-Expression arctanProcedure(const std::vector<Atom>& args) 
+void arctanProcedure(Arguments args, Atom& result) 
 {
     if (args.size() != 2 || args[0].type != NumberType || args[1].type != NumberType) 
     {
         throw InterpreterSemanticError("Error: Invalid number of arguments for arctan, expected 2.");
     }
-    return Expression(std::atan2(args[0].value.num_value, args[1].value.num_value));
+    setResult(result, std::atan2(args[0].value.num_value, args[1].value.num_value));
 }
 
-Expression drawProcedure(const std::vector<Atom>& args)
+void drawProcedure(Arguments args, Atom& result)
 {
     if (args.empty())
     {
@@ -294,50 +362,41 @@ Expression drawProcedure(const std::vector<Atom>& args)
     }
 
     // Check each argument to ensure it's a graphical object and "draw" them
+    Atom drawn;
     for (size_t i = 0; i < args.size(); ++i)
     {
         const auto& arg = args[i];
 
         if (arg.type == SymbolType)
         {
-            if (arg.value.sym_value == "point" && (i + 2) < args.size() && args[i + 1].type == NumberType && args[i + 2].type == NumberType)
+            if (arg.value.sym_value == POINT_SYMBOL && (i + 2) < args.size() && args[i + 1].type == NumberType && args[i + 2].type == NumberType)
             {
-                pointProcedure({ args[i + 1], args[i + 2] });
+                pointProcedure(Arguments(&args[i + 1], 2), drawn);
                 i += 2; // skip the next two arguments
             }
-            else if (arg.value.sym_value == "line" && (i + 2) < args.size() && args[i + 1].type == PointType && args[i + 2].type == PointType)
+            else if (arg.value.sym_value == LINE_SYMBOL && (i + 2) < args.size() && args[i + 1].type == PointType && args[i + 2].type == PointType)
             {
                 // Draw the points of the line
-                pointProcedure({ args[i + 1] });
-                pointProcedure({ args[i + 2] });
-                lineProcedure({ args[i + 1], args[i + 2] });
+                pointProcedure(Arguments(&args[i + 1], 1), drawn);
+                pointProcedure(Arguments(&args[i + 2], 1), drawn);
+                lineProcedure(Arguments(&args[i + 1], 2), drawn);
                 i += 2; // skip the next two arguments
             }
-            else if (arg.value.sym_value == "arc" && (i + 3) < args.size() && args[i + 1].type == PointType && args[i + 2].type == PointType && args[i + 3].type == NumberType)
+            else if (arg.value.sym_value == ARC_SYMBOL && (i + 3) < args.size() && args[i + 1].type == PointType && args[i + 2].type == PointType && args[i + 3].type == NumberType)
             {
                 // Draw the points of the arc
-                pointProcedure({ args[i + 1] });
-                pointProcedure({ args[i + 2] });
-                arcProcedure({ args[i + 1], args[i + 2], args[i + 3] });
+                pointProcedure(Arguments(&args[i + 1], 1), drawn);
+                pointProcedure(Arguments(&args[i + 2], 1), drawn);
+                arcProcedure(Arguments(&args[i + 1], 3), drawn);
                 i += 3; // skip the next three arguments
             }
         }
-        else if (arg.type == PointType)
-        {
-            return Expression(std::make_tuple(arg.value.point_value.x, arg.value.point_value.y));
-        }
-        else if (arg.type == LineType)
-        {
-            Point startPoint = arg.value.line_value.first;
-            Point endPoint = arg.value.line_value.second;
-            return Expression(std::make_tuple(startPoint.x, startPoint.y), std::make_tuple(endPoint.x, endPoint.y));
-        }
-        else if (arg.type == ArcType)
+        else if (arg.type == PointType || arg.type == LineType || arg.type == ArcType || arg.type == ArrayType)
         {
-            Point centerPoint = arg.value.arc_value.center;
-            Point startPoint = arg.value.arc_value.start;
-            double angle = arg.value.arc_value.span;
-            return Expression(std::make_tuple(centerPoint.x, centerPoint.y), std::make_tuple(startPoint.x, startPoint.y), angle);
+            // Graphics are drawn as they are, and the numbers of an array
+            // as x y pairs of points
+            result = arg;
+            return;
         }
         else
         {
@@ -346,11 +405,9 @@ Expression drawProcedure(const std::vector<Atom>& args)
     }
 
     // Return an expression of type None after "drawing" all objects
-    return Expression();
+    result.type = NoneType;
 }
 
-
-
 //Class constructor
 //Contains built in symbols and procedures
 Environment::Environment()
@@ -358,106 +415,220 @@ Environment::Environment()
     //Built in symbols
     addSymbol("pi", Expression(atan2(0, -1)));
 
-    //Built in procedures
-    addProcedure("not", notProcedure);
-    addProcedure("and", andProcedure);
-    addProcedure("or", orProcedure);
-    addProcedure("<", lessThanProcedure);
-    addProcedure("<=", lessThanOrEqualProcedure);
-    addProcedure(">", greaterThanProcedure);
-    addProcedure(">=", greaterThanOrEqualProcedure);
-    addProcedure("=", equalProcedure);
-    addProcedure("+", ADDProcedure);
-    addProcedure("-", subtractProcedure);
-    addProcedure("*", multiplyProcedure);
-    addProcedure("/", divideProcedure);
-    addProcedure("log10", log10Procedure);
-    addProcedure("pow", powProcedure);
+    //Built in procedures, which all compute their value from their
+    //arguments alone. The values of the transcendental ones are worth
+    //keeping, the others cost less than looking a value up
+    addProcedure("not", notProcedure, Pure);
+    addProcedure("and", andProcedure, Pure);
+    addProcedure("or", orProcedure, Pure);
+    addProcedure("<", lessThanProcedure, Pure);
+    addProcedure("<=", lessThanOrEqualProcedure, Pure);
+    addProcedure(">", greaterThanProcedure, Pure);
+    addProcedure(">=", greaterThanOrEqualProcedure, Pure);
+    addProcedure("=", equalProcedure, Pure);
+    addProcedure("+", ADDProcedure, Pure);
+    addProcedure("-", subtractProcedure, Pure);
+    addProcedure("*", multiplyProcedure, Pure);
+    addProcedure("/", divideProcedure, Pure);
+    addProcedure("log10", log10Procedure, PureCostly);
+    addProcedure("pow", powProcedure, PureCostly);
+    addProcedure("length", lengthProcedure, Pure);
+    addProcedure("nth", nthProcedure, Pure);
 
     // New procedures for graphical operations
-    addProcedure("draw", drawProcedure);
-    addProcedure("point", pointProcedure);
-    addProcedure("line", lineProcedure);
-    addProcedure("arc", arcProcedure);
-    addProcedure("sin", sinProcedure);
-    addProcedure("cos", cosProcedure);
-    addProcedure("arctan", arctanProcedure);
+    addProcedure("draw", drawProcedure, Pure);
+    addProcedure("point", pointProcedure, Pure);
+    addProcedure("line", lineProcedure, Pure);
+    addProcedure("arc", arcProcedure, Pure);
+    addProcedure("sin", sinProcedure, PureCostly);
+    addProcedure("cos", cosProcedure, PureCostly);
+    addProcedure("arctan", arctanProcedure, PureCostly);
 
 }
 
 //Adds a given symbol to the environment
 void Environment::addSymbol(const Symbol& symbol, const Expression& value)
+{
+    addSymbol(symbol, Expression(value));
+}
+
+void Environment::addSymbol(const Symbol& symbol, Expression&& value)
+{
+    addSymbol(slot(symbol), std::move(value));
+}
+
+void Environment::addSymbol(Slot slot, Expression&& value)
 {
     EnvResult result;
     result.type = ExpressionType;
-    result.exp = value;
-    envmap[symbol] = result;
+    result.exp = std::move(value);
+
+    // The numbers of an array are copied, as the program they came from
+    // may be replaced while the symbol is still defined
+    result.exp.ownNumbers();
+
+    bindings[slot] = std::move(result);
 }
 
 //Adds a given procedure to the environment
-void Environment::addProcedure(const Symbol& symbol, Procedure procedure)
+void Environment::addProcedure(const Symbol& symbol, Procedure procedure, Purity purity)
 {
     EnvResult result;
     result.type = ProcedureType;
     result.proc = procedure;
-    envmap[symbol] = result;
+    result.purity = purity;
+    if (memo != nullptr && purity == PureCostly)
+    {
+        result.memo = memo->memoize(procedure);
+    }
+    bindings[slot(symbol)] = std::move(result);
 }
 
 //Gets the procedure / symbol based on the given symbol
+//the copy is O(1), as the tail of the expression is shared
 Expression Environment::get(const Symbol& symbol)
 {
-    auto it = envmap.find(symbol);
-    if (it != envmap.end() && it->second.type == ExpressionType)
+    return get(find(symbol));
+}
+
+Expression Environment::get(Slot slot)
+{
+    const Expression* exp = lookup(slot);
+    if (exp != nullptr)
     {
-        return it->second.exp;
+        return *exp;
     }
     throw InterpreterSemanticError("Error: Symbol not found or not associated with an expression.");
 }
 
+Environment::Slot Environment::slot(const Symbol& symbol)
+{
+    if (symbol.id() >= slotOf.size())
+    {
+        slotOf.resize(symbol.id() + 1, NO_SLOT);
+    }
+    if (slotOf[symbol.id()] == NO_SLOT)
+    {
+        slotOf[symbol.id()] = static_cast<Slot>(bindings.size());
+        bindings.emplace_back();
+    }
+    return slotOf[symbol.id()];
+}
+
+Environment::Slot Environment::find(const Symbol& symbol) const noexcept
+{
+    return symbol.id() < slotOf.size() ? slotOf[symbol.id()] : NO_SLOT;
+}
+
+const Expression* Environment::lookup(const Symbol& symbol) const noexcept
+{
+    return lookup(find(symbol));
+}
+
+const Expression* Environment::lookup(Slot slot) const noexcept
+{
+    if (slot < bindings.size() && bindings[slot].type == ExpressionType)
+    {
+        return &bindings[slot].exp;
+    }
+    return nullptr;
+}
+
 //Checks if the symbol is defined in the environment
 bool Environment::isSymbolDefined(const Symbol& symbol)
 {
-    return envmap.find(symbol) != envmap.end();
+    const Slot slot = find(symbol);
+    return slot != NO_SLOT && bindings[slot].type != UnboundType;
 }
 
 
 
 //Evaluates procedure based on type
 /*
-* This function takes a symbol and a vector of arguments and looks up the symbol
-* in the environment. If the symbol is found and associated with a procedure, it
-* evaluates the procedure with the provided arguments. The procedure is expected
-* to be a callable function that can accept a vector of Atom arguments and return
-* an Expression result.
+* This function takes a symbol and the evaluated arguments of a call and looks
+* up the symbol in the environment. If the symbol is found and associated with
+* a procedure, it applies the procedure to the arguments, which writes its value
+* to result. The arguments are checked and converted where they are, so a call
+* copies and allocates nothing.
 */
-Expression Environment::evaluateProcedure(const Symbol& symbol, const std::vector<Expression>& args)
+void Environment::evaluateProcedure(const Symbol& symbol, Atom* args, std::size_t count, Atom& result)
 {
-    auto it = envmap.find(symbol);
-    if (it != envmap.end() && it->second.type == ProcedureType)
+    evaluateProcedure(find(symbol), args, count, result);
+}
+
+void Environment::evaluateProcedure(Slot slot, Atom* args, std::size_t count, Atom& result)
+{
+    const Callee proc = callee(slot);
+    if (proc.proc != nullptr)
     {
-        std::vector<Atom> atomArgs;
+        apply(proc, args, count, result);
+        return;
+    }
 
-        for (const auto& exp : args)
-        {
-            Atom atom = exp.head; // Directly use the head of the Expression as the Atom
+    throw InterpreterSemanticError("Error: Symbol not found or not associated with a procedure.");
+}
 
-            // Check if the Atom is of a type that needs to be converted to another Atom type
-            if (atom.type == SymbolType && !token_to_atom(atom.value.sym_value, atom))
-            {
-                throw InterpreterSemanticError("Error: Failed to convert symbol to atom.");
-            }
-            else if (atom.type != NumberType && atom.type != BooleanType &&
-                atom.type != PointType && atom.type != LineType && atom.type != ArcType)
-            {
-                // If the atom type is not one of the expected types, throw an error
-                throw InterpreterSemanticError("Error: Unexpected expression type.");
-            }
+Environment::Callee Environment::callee(Slot slot) const noexcept
+{
+    Callee found;
+    if (slot < bindings.size() && bindings[slot].type == ProcedureType)
+    {
+        found.proc = bindings[slot].proc;
+        found.memo = bindings[slot].memo;
+    }
+    return found;
+}
+
+bool Environment::isPure(Slot slot) const noexcept
+{
+    return slot < bindings.size() && bindings[slot].type == ProcedureType && bindings[slot].purity != Impure;
+}
 
-            atomArgs.push_back(atom);
+void Environment::apply(const Callee& callee, Atom* args, std::size_t count, Atom& result)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const Atom& atom = args[i];
+
+        // A symbol was read from a token that was not a number or a
+        // boolean, so reading its name again would only give the symbol
+        if (atom.type != SymbolType && atom.type != NumberType && atom.type != BooleanType &&
+            atom.type != PointType && atom.type != LineType && atom.type != ArcType && atom.type != ArrayType)
+        {
+            // If the atom type is not one of the expected types, throw an error
+            throw InterpreterSemanticError("Error: Unexpected expression type.");
         }
+    }
 
-        return it->second.proc(atomArgs);
+    // A callee looked up before the cache was set up goes around it
+    if (callee.memo != NOT_MEMOIZED && memo != nullptr)
+    {
+        memo->apply(callee.memo, callee.proc, args, count, result);
+        return;
     }
+    callee.proc(Arguments(args, count), result);
+}
 
-    throw InterpreterSemanticError("Error: Symbol not found or not associated with a procedure.");
+void Environment::setMemoCapacity(std::size_t entries)
+{
+    // The bindings of the costly procedures remember where the cache
+    // keeps their values, so other calls never look at the cache
+    memo.reset();
+    if (entries != 0)
+    {
+        memo = std::make_shared<MemoCache>(entries);
+    }
+    for (EnvResult& binding : bindings)
+    {
+        binding.memo = NOT_MEMOIZED;
+        if (memo != nullptr && binding.type == ProcedureType && binding.purity == PureCostly)
+        {
+            binding.memo = memo->memoize(binding.proc);
+        }
+    }
+}
+
+MemoStats Environment::memoStats() const noexcept
+{
+    return memo != nullptr ? memo->stats() : MemoStats();
 }
@@ -2,48 +2,117 @@
 #define ENVIRONMENT_HPP
 
 // system includes
-#include <map>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 // module includes
 #include "expression.hpp"
+#include "memo.hpp"
 
-Expression notProcedure(const std::vector<Atom>& args);
-Expression andProcedure(const std::vector<Atom>& args);
-Expression orProcedure(const std::vector<Atom>& args);
-Expression ADDProcedure(const std::vector<Atom>& args);
-Expression subtractProcedure(const std::vector<Atom>& args);
-Expression multiplyProcedure(const std::vector<Atom>& args);
-Expression divideProcedure(const std::vector<Atom>& args);
-Expression lessThanProcedure(const std::vector<Atom>& args);
-Expression lessThanOrEqualProcedure(const std::vector<Atom>& args);
-Expression greaterThanProcedure(const std::vector<Atom>& args);
-Expression greaterThanOrEqualProcedure(const std::vector<Atom>& args);
-Expression equalProcedure(const std::vector<Atom>& args);
-Expression log10Procedure(const std::vector<Atom>& args);
-Expression powProcedure(const std::vector<Atom>& args);
+void notProcedure(Arguments args, Atom& result);
+void andProcedure(Arguments args, Atom& result);
+void orProcedure(Arguments args, Atom& result);
+void ADDProcedure(Arguments args, Atom& result);
+void subtractProcedure(Arguments args, Atom& result);
+void multiplyProcedure(Arguments args, Atom& result);
+void divideProcedure(Arguments args, Atom& result);
+void lessThanProcedure(Arguments args, Atom& result);
+void lessThanOrEqualProcedure(Arguments args, Atom& result);
+void greaterThanProcedure(Arguments args, Atom& result);
+void greaterThanOrEqualProcedure(Arguments args, Atom& result);
+void equalProcedure(Arguments args, Atom& result);
+void log10Procedure(Arguments args, Atom& result);
+void powProcedure(Arguments args, Atom& result);
+void lengthProcedure(Arguments args, Atom& result);
+void nthProcedure(Arguments args, Atom& result);
 
 class Environment
 {
 public:
+  // Every name the environment has seen has a slot, an index that stays
+  // the same for the life of the environment. A program resolved against
+  // the environment refers to its names by slot, so it reads and binds
+  // them without looking the name up
+  typedef std::uint32_t Slot;
+
   Environment();
   void addSymbol(const Symbol& symbol, const Expression& value);
-  void addProcedure(const Symbol& symbol, Procedure procedure);
+  void addSymbol(const Symbol& symbol, Expression&& value);
+  void addSymbol(Slot slot, Expression&& value);
+  // What the value of a procedure depends on. A pure one computes it
+  // from its arguments alone, so a call with known arguments can be made
+  // early, and a costly one is worth keeping the values of too
+  enum Purity {Impure, Pure, PureCostly};
+  void addProcedure(const Symbol& symbol, Procedure procedure, Purity purity = Impure);
   Expression get(const Symbol& symbol);
+  Expression get(Slot slot);
+
+  // the slot of symbol, a new unbound one if it has none yet
+  Slot slot(const Symbol& symbol);
+
+  // the expression bound to symbol, or nullptr if it has none. The
+  // pointer is valid until the symbol is bound again
+  const Expression* lookup(const Symbol& symbol) const noexcept;
+  const Expression* lookup(Slot slot) const noexcept;
   bool isSymbolDefined(const Symbol& symbol);
-  Expression evaluateProcedure(const Symbol& symbol, const std::vector<Expression>& args);
+  // apply the procedure bound to symbol to the count evaluated args,
+  // writing its value to result. The args may be converted in place
+  void evaluateProcedure(const Symbol& symbol, Atom* args, std::size_t count, Atom& result);
+  void evaluateProcedure(Slot slot, Atom* args, std::size_t count, Atom& result);
+
+  // A procedure looked up once to be applied many times, and the index
+  // of its values in the memo cache, if the cache keeps them
+  static constexpr std::uint32_t NOT_MEMOIZED = ~std::uint32_t(0);
+  struct Callee
+  {
+    Procedure proc = nullptr;
+    std::uint32_t memo = NOT_MEMOIZED;
+  };
+
+  // the procedure bound to slot, with a null proc if it has none
+  Callee callee(Slot slot) const noexcept;
+
+  // true if slot is bound to a pure procedure
+  bool isPure(Slot slot) const noexcept;
+
+  // apply a procedure looked up before to the count evaluated args.
+  // Only procedures the memo cache keeps the values of go through it
+  void apply(const Callee& callee, Atom* args, std::size_t count, Atom& result);
+
+  // keep the values of recent calls to the costly pure procedures in a
+  // cache of about entries values, or keep none if entries is 0
+  void setMemoCapacity(std::size_t entries);
+  // the lookups in that cache since it was set up
+  MemoStats memoStats() const noexcept;
 
 
 private:
 
-  // Environment is a mapping from symbols to expressions or procedures
-  enum EnvResultType {ExpressionType, ProcedureType};
+  // Environment is a mapping from symbols to expressions or procedures,
+  // one binding for each slot. A slot is unbound until its symbol is
+  // defined
+  enum EnvResultType {UnboundType, ExpressionType, ProcedureType};
   struct EnvResult{
-    EnvResultType type;
+    EnvResultType type = UnboundType;
     Expression exp;
-    Procedure proc;
+    Procedure proc = nullptr;
+    Purity purity = Impure;
+    std::uint32_t memo = NOT_MEMOIZED;
   };
 
-  std::map<Symbol,EnvResult> envmap;
+  static constexpr Slot NO_SLOT = ~Slot(0);
+
+  // the slot of symbol, or NO_SLOT if it has none
+  Slot find(const Symbol& symbol) const noexcept;
+
+  std::vector<EnvResult> bindings;
+
+  // The slot of each symbol by its id, as ids are small and dense
+  std::vector<Slot> slotOf;
+
+  // The memo cache, if any. Shared, as its values hold for any copy
+  std::shared_ptr<MemoCache> memo;
 };
 
 #endif
@@ -8,6 +8,20 @@
 #include <cctype>
 #include <tuple>
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <system_error>
+#include <cerrno>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+// module includes
+#include "tokenize.hpp"
+#include "small_vector.hpp"
 
 Expression::Expression(bool tf)
 {
@@ -54,16 +68,230 @@ Expression::Expression(std::tuple<double,double> center, std::tuple<double,doubl
 	head.value.arc_value.span = angle;
 }
 
-bool Expression::operator==(const Expression & exp) const noexcept
+// Numbers hash by their bits, as identical() compares them, so 0 and -0
+// hash apart and a NaN hashes alike with itself
+static std::size_t hashNumber(Number num) noexcept
+{
+	std::uint64_t bits;
+	std::memcpy(&bits, &num, sizeof(bits));
+	return static_cast<std::size_t>(bits);
+}
+
+static std::size_t hashPoint(std::size_t seed, const Point & point) noexcept
+{
+	return mixHash(mixHash(seed, hashNumber(point.x)), hashNumber(point.y));
+}
+
+std::size_t hashNumbers(const Number * data, std::size_t size) noexcept
+{
+	std::size_t seed = size;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		seed = mixHash(seed, hashNumber(data[i]));
+	}
+	return seed;
+}
+
+static std::size_t hashAtom(const Atom & atom) noexcept
+{
+	std::size_t seed = atom.type;
+	switch (atom.type)
+	{
+	case BooleanType:
+		return mixHash(seed, atom.value.bool_value);
+	case NumberType:
+		return mixHash(seed, hashNumber(atom.value.num_value));
+	case SymbolType:
+		return mixHash(seed, std::hash<Symbol>()(atom.value.sym_value));
+	case PointType:
+		return hashPoint(seed, atom.value.point_value);
+	case LineType:
+		return hashPoint(hashPoint(seed, atom.value.line_value.first), atom.value.line_value.second);
+	case ArcType:
+		seed = hashPoint(hashPoint(seed, atom.value.arc_value.center), atom.value.arc_value.start);
+		return mixHash(seed, hashNumber(atom.value.arc_value.span));
+	case ArrayType:
+		return mixHash(seed, atom.value.array_value.hash);
+	default:
+		return seed;
+	}
+}
+
+struct ExpressionList::SharedBlock
+{
+	std::atomic<std::size_t> refs;
+};
+
+// the elements start after the count, at the alignment of an Expression
+static const std::size_t SHARED_HEADER =
+	(sizeof(std::atomic<std::size_t>) + alignof(Expression) - 1) / alignof(Expression) * alignof(Expression);
+
+// size as the count of a list, which must fit in its 31 bits
+static std::uint32_t listCount(std::size_t size)
+{
+	if (size > ExpressionList::MAX_SIZE)
+	{
+		throw std::length_error("Error: list has too many elements.");
+	}
+	return static_cast<std::uint32_t>(size);
+}
+
+ExpressionList::ExpressionList(const std::vector<Expression> & exps)
+	: items(nullptr), count(0), owned(false), elementsHash(0)
+{
+	const std::uint32_t size = listCount(exps.size());
+	share(size * sizeof(Expression));
+	std::uninitialized_copy(exps.begin(), exps.end(), const_cast<Expression *>(items));
+	count = size;
+	rehash();
+}
+
+ExpressionList::ExpressionList(std::vector<Expression> && exps)
+	: items(nullptr), count(0), owned(false), elementsHash(0)
+{
+	const std::uint32_t size = listCount(exps.size());
+	share(size * sizeof(Expression));
+	std::uninitialized_move(exps.begin(), exps.end(), const_cast<Expression *>(items));
+	count = size;
+	rehash();
+}
+
+ExpressionList::ExpressionList(const ExpressionList & list)
+	: items(list.items), count(list.count), owned(list.owned), elementsHash(list.elementsHash)
+{
+	// A view and a shared block are both copied by reference
+	acquire();
+}
+
+ExpressionList::ExpressionList(ExpressionList && list) noexcept
+	: items(list.items), count(list.count), owned(list.owned), elementsHash(list.elementsHash)
+{
+	list.items = nullptr;
+	list.count = 0;
+	list.owned = false;
+	list.elementsHash = 0;
+}
+
+ExpressionList & ExpressionList::operator=(const ExpressionList & list)
+{
+	list.acquire();
+	release();
+	items = list.items;
+	count = list.count;
+	owned = list.owned;
+	elementsHash = list.elementsHash;
+	return *this;
+}
+
+ExpressionList & ExpressionList::operator=(ExpressionList && list) noexcept
+{
+	if (this != &list)
+	{
+		release();
+		items = list.items;
+		count = list.count;
+		owned = list.owned;
+		elementsHash = list.elementsHash;
+		list.items = nullptr;
+		list.count = 0;
+		list.owned = false;
+		list.elementsHash = 0;
+	}
+	return *this;
+}
+
+ExpressionList::~ExpressionList()
+{
+	release();
+}
+
+ExpressionList ExpressionList::view(const Expression * items, std::size_t count)
+{
+	ExpressionList list;
+	list.count = listCount(count);
+	list.items = count == 0 ? nullptr : items;
+	list.rehash();
+	return list;
+}
+
+ExpressionList ExpressionList::numbers(const Number * data, std::size_t size, const Number *& copy)
+{
+	static_assert(alignof(Number) <= alignof(Expression), "Numbers should fit the alignment of a shared block");
+
+	// The list has no elements, so only the block holds the Numbers and
+	// the list hashes and compares as an empty one
+	ExpressionList list;
+	list.share(size * sizeof(Number));
+	Number * numbers = reinterpret_cast<Number *>(const_cast<Expression *>(list.items));
+	std::copy(data, data + size, numbers);
+	copy = numbers;
+	return list;
+}
+
+// allocate a block for bytes of elements, left unconstructed, with one
+// reference
+void ExpressionList::share(std::size_t bytes)
+{
+	if (bytes == 0)
+	{
+		return;
+	}
+	unsigned char * storage = static_cast<unsigned char *>(::operator new(SHARED_HEADER + bytes));
+	new (storage) SharedBlock{ {1} };
+	items = reinterpret_cast<Expression *>(storage + SHARED_HEADER);
+	owned = true;
+}
+
+void ExpressionList::acquire() const noexcept
+{
+	if (owned)
+	{
+		const unsigned char * storage = reinterpret_cast<const unsigned char *>(items) - SHARED_HEADER;
+		const SharedBlock * block = reinterpret_cast<const SharedBlock *>(storage);
+		const_cast<SharedBlock *>(block)->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void ExpressionList::release() noexcept
+{
+	if (owned)
+	{
+		unsigned char * storage = const_cast<unsigned char *>(reinterpret_cast<const unsigned char *>(items)) - SHARED_HEADER;
+		SharedBlock * block = reinterpret_cast<SharedBlock *>(storage);
+		if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			std::destroy(items, items + count);
+			block->~SharedBlock();
+			::operator delete(storage);
+		}
+	}
+	items = nullptr;
+	count = 0;
+	owned = false;
+	elementsHash = 0;
+}
+
+void ExpressionList::rehash() noexcept
+{
+	std::size_t seed = count;
+	for (const Expression & exp : *this)
+	{
+		seed = mixHash(seed, exp.hash());
+	}
+	elementsHash = static_cast<std::uint32_t>(seed ^ (seed >> 32));
+}
+
+// Compare two heads, with a tolerance for numbers and geometry
+static bool sameHead(const Atom & head, const Atom & other) noexcept
 {
 	// Compare types
-	if (head.type != exp.head.type)
+	if (head.type != other.type)
 	{
 		return false;
 	}
 
 	// Check if both expressions have NoneType heads
-	if (head.type == NoneType && exp.head.type == NoneType)
+	if (head.type == NoneType && other.type == NoneType)
 	{
 		return true;
 	}
@@ -71,21 +299,39 @@ bool Expression::operator==(const Expression & exp) const noexcept
 	switch (head.type)
 	{
 	case BooleanType:
-		return head.value.bool_value == exp.head.value.bool_value;
+		return head.value.bool_value == other.value.bool_value;
 	case NumberType:
 		// Compare floating-point numbers with tolerance
-		return std::abs(head.value.num_value - exp.head.value.num_value) <= std::numeric_limits<double>::epsilon();
+		return std::abs(head.value.num_value - other.value.num_value) <= std::numeric_limits<double>::epsilon();
 	case SymbolType:
-		return head.value.sym_value == exp.head.value.sym_value;
+		return head.value.sym_value == other.value.sym_value;
 	case PointType:
-		return head.value.point_value == exp.head.value.point_value;
+		return head.value.point_value == other.value.point_value;
 	case LineType:
-		return (head.value.line_value.first == exp.head.value.line_value.first) &&
-			(head.value.line_value.second == exp.head.value.line_value.second);
+		return (head.value.line_value.first == other.value.line_value.first) &&
+			(head.value.line_value.second == other.value.line_value.second);
 	case ArcType:
-		return (head.value.arc_value.center == exp.head.value.arc_value.center) &&
-			(head.value.arc_value.start == exp.head.value.arc_value.start) &&
-			(fabs(head.value.arc_value.span - exp.head.value.arc_value.span) < std::numeric_limits<double>::epsilon());
+		return (head.value.arc_value.center == other.value.arc_value.center) &&
+			(head.value.arc_value.start == other.value.arc_value.start) &&
+			(fabs(head.value.arc_value.span - other.value.arc_value.span) < std::numeric_limits<double>::epsilon());
+	case ArrayType:
+	{
+		// Element by element, with the same tolerance as numbers
+		const Array & a = head.value.array_value;
+		const Array & b = other.value.array_value;
+		if (a.size != b.size)
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < a.size; ++i)
+		{
+			if (!(std::abs(a.data[i] - b.data[i]) <= std::numeric_limits<double>::epsilon()))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 	default:
 		std::cerr << "ERROR: Invalid type " << std::endl;
 		return false; // Invalid type
@@ -93,51 +339,292 @@ bool Expression::operator==(const Expression & exp) const noexcept
 	return true;
 }
 
-std::ostream & operator<<(std::ostream & out, const Expression & exp)
+static bool identicalPoint(const Point & a, const Point & b) noexcept
 {
-	if (exp.tail.empty())
+	return hashNumber(a.x) == hashNumber(b.x) && hashNumber(a.y) == hashNumber(b.y);
+}
+
+// Compare two heads by their bits, the way they are hashed
+static bool identicalHead(const Atom & head, const Atom & other) noexcept
+{
+	if (head.type != other.type)
+	{
+		return false;
+	}
+
+	switch (head.type)
+	{
+	case BooleanType:
+		return head.value.bool_value == other.value.bool_value;
+	case NumberType:
+		return hashNumber(head.value.num_value) == hashNumber(other.value.num_value);
+	case SymbolType:
+		return head.value.sym_value == other.value.sym_value;
+	case PointType:
+		return identicalPoint(head.value.point_value, other.value.point_value);
+	case LineType:
+		return identicalPoint(head.value.line_value.first, other.value.line_value.first) &&
+			identicalPoint(head.value.line_value.second, other.value.line_value.second);
+	case ArcType:
+		return identicalPoint(head.value.arc_value.center, other.value.arc_value.center) &&
+			identicalPoint(head.value.arc_value.start, other.value.arc_value.start) &&
+			hashNumber(head.value.arc_value.span) == hashNumber(other.value.arc_value.span);
+	case ArrayType:
+	{
+		const Array & a = head.value.array_value;
+		const Array & b = other.value.array_value;
+		return a.size == b.size && a.hash == b.hash &&
+			(a.size == 0 || std::memcmp(a.data, b.data, a.size * sizeof(Number)) == 0);
+	}
+	default:
+		return true;
+	}
+}
+
+// The tails are walked with an explicit stack, as deep as the trees
+// are, and tails in the same storage are equal without looking at them.
+// Only an identical comparison may tell tails apart by their hashes
+template<bool Identical>
+static bool sameTree(const Expression & first, const Expression & second) noexcept
+{
+	SmallVector<std::pair<const Expression *, const Expression *>, 16> pending;
+	pending.emplace_back(&first, &second);
+	while (!pending.empty())
 	{
-		if (exp.head.type == BooleanType)
+		const Expression & a = *pending.back().first;
+		const Expression & b = *pending.back().second;
+		pending.pop_back();
+
+		if (a.tail.size() != b.tail.size())
 		{
-			out << (exp.head.value.bool_value ? "True" : "False");
+			return false;
 		}
-		else if (exp.head.type == NumberType)
+		if (Identical ? (a.tail.hash() != b.tail.hash() || !identicalHead(a.head, b.head)) : !sameHead(a.head, b.head))
 		{
-			out << exp.head.value.num_value;
+			return false;
 		}
-		else if (exp.head.type == SymbolType)
+		if (a.tail.begin() != b.tail.begin())
 		{
-			out << exp.head.value.sym_value;
+			for (std::size_t i = 0; i < a.tail.size(); ++i)
+			{
+				pending.emplace_back(&a.tail[i], &b.tail[i]);
+			}
 		}
-		else if (exp.head.type == PointType) 
+	}
+	return true;
+}
+
+bool Expression::operator==(const Expression & exp) const noexcept
+{
+	return sameTree<false>(*this, exp);
+}
+
+bool Expression::identical(const Expression & exp) const noexcept
+{
+	return sameTree<true>(*this, exp);
+}
+
+std::size_t Expression::hash() const noexcept
+{
+	// The tail keeps a 32 bit hash, which is widened to be mixed in
+	return mixHash(hashAtom(head), static_cast<std::size_t>(tail.hash()));
+}
+
+void Expression::ownNumbers()
+{
+	if (head.type == ArrayType)
+	{
+		Array & array = head.value.array_value;
+		tail = ExpressionList::numbers(array.data, array.size, array.data);
+	}
+}
+
+// print an atom, as an expression with an empty tail is printed
+static void printAtom(std::ostream & out, const Atom & atom)
+{
+	if (atom.type == BooleanType)
+	{
+		out << (atom.value.bool_value ? "True" : "False");
+	}
+	else if (atom.type == NumberType)
+	{
+		out << atom.value.num_value;
+	}
+	else if (atom.type == SymbolType)
+	{
+		out << atom.value.sym_value;
+	}
+	else if (atom.type == PointType) 
+	{
+		out << "(" << atom.value.point_value.x << "," << atom.value.point_value.y << ")";
+	}
+	else if (atom.type == LineType) 
+	{
+		out << "((" << atom.value.line_value.first.x << "," << atom.value.line_value.first.y << ")," << "(" << atom.value.line_value.second.x << "," << atom.value.line_value.second.y << "))";
+	}
+	else if (atom.type == ArcType) 
+	{
+		out << "((" << atom.value.arc_value.center.x << "," << atom.value.arc_value.center.y << ")," << "(" << atom.value.arc_value.start.x << "," << atom.value.arc_value.start.y << ")," << atom.value.arc_value.span << ")";
+	}
+	else if (atom.type == ArrayType)
+	{
+		out << ARRAY_OPEN;
+		for (std::size_t i = 0; i < atom.value.array_value.size; ++i)
 		{
-			out << "(" << exp.head.value.point_value.x << "," << exp.head.value.point_value.y << ")";
+			out << (i == 0 ? "" : " ") << atom.value.array_value.data[i];
 		}
-		else if (exp.head.type == LineType) 
+		out << ARRAY_CLOSE;
+	}
+}
+
+std::ostream & operator<<(std::ostream & out, const Expression & exp)
+{
+	if (exp.tail.empty())
+	{
+		printAtom(out, exp.head);
+		return out;
+	}
+
+	// The lists being printed, and the next element of each, are kept on
+	// an explicit stack, so any AST the parser accepts can be printed
+	struct OpenList
+	{
+		const Expression * exp;
+		std::size_t next;
+	};
+	std::vector<OpenList> open{ { &exp, 0 } };
+	out << "(";
+	printAtom(out, exp.head);
+	while (!open.empty())
+	{
+		OpenList & top = open.back();
+		if (top.next == top.exp->tail.size())
 		{
-			out << "((" << exp.head.value.line_value.first.x << "," << exp.head.value.line_value.first.y << ")," << "(" << exp.head.value.line_value.second.x << "," << exp.head.value.line_value.second.y << "))";
+			out << ")";
+			open.pop_back();
+			continue;
 		}
-		else if (exp.head.type == ArcType) 
+
+		const Expression & item = top.exp->tail[top.next++];
+		out << " ";
+		if (!item.tail.empty())
 		{
-			out << "((" << exp.head.value.arc_value.center.x << "," << exp.head.value.arc_value.center.y << ")," << "(" << exp.head.value.arc_value.start.x << "," << exp.head.value.arc_value.start.y << ")," << exp.head.value.arc_value.span << ")";
+			out << "(";
+			open.push_back({ &item, 0 });
 		}
+		printAtom(out, item.head);
+	}
+
+	return out;
+}
+
+namespace
+{
+	// Result of reading a token as a number
+	enum class NumberParse {NotANumber, Number, OutOfRange};
+
+	// Characters std::isspace accepts in the "C" locale
+	bool isSpace(char c)
+	{
+		return c == ' ' || (c >= '\t' && c <= '\r');
 	}
-	else
+
+	// Table of the characters a number can start with: digits, a sign,
+	// a decimal point, the first letter of inf/nan and leading whitespace.
+	// Any other first character makes the token a symbol without trying
+	// to read a number at all
+	struct NumberLeadTable
+	{
+		bool lead[256] = {};
+
+		NumberLeadTable()
+		{
+			for (const char c : std::string_view("0123456789+-.iInN \t\n\v\f\r"))
+			{
+				lead[static_cast<unsigned char>(c)] = true;
+			}
+		}
+	};
+
+	const NumberLeadTable numberLeads;
+
+	// Read the whole token as a double without throwing. This accepts
+	// what std::stod accepts (leading whitespace, one sign, decimal and
+	// hexadecimal forms, inf and nan) and reports the same underflow and
+	// overflow cases as out of range
+	NumberParse parseNumber(std::string_view token, double & num)
 	{
-		out << "(" << exp.head;
+		std::size_t start = 0;
+		while (start < token.size() && isSpace(token[start]))
+		{
+			++start;
+		}
 
-		for (const Expression& tailExpr : exp.tail)
+		bool negative = false;
+		if (start < token.size() && (token[start] == '+' || token[start] == '-'))
 		{
-			out << " " << tailExpr;
+			negative = token[start] == '-';
+			++start;
 		}
 
-		out << ")";
-	}
+		const char * first = token.data() + start;
+		const char * last = token.data() + token.size();
 
-	return out;
+		std::chars_format format = std::chars_format::general;
+		if (last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+		{
+			format = std::chars_format::hex;
+			first += 2;
+
+			// from_chars would read 0xinf and 0xnan, std::stod wants hex
+			// digits after the prefix
+			const bool digits = std::isxdigit(static_cast<unsigned char>(first[0])) ||
+				(first[0] == '.' && last - first > 1 && std::isxdigit(static_cast<unsigned char>(first[1])));
+			if (!digits)
+			{
+				return NumberParse::NotANumber;
+			}
+		}
+
+		// from_chars takes a sign of its own, std::stod only takes one
+		// before the number
+		if (first == last || *first == '+' || *first == '-')
+		{
+			return NumberParse::NotANumber;
+		}
+
+		const std::from_chars_result result = std::from_chars(first, last, num, format);
+		if (result.ec == std::errc::result_out_of_range)
+		{
+			return NumberParse::OutOfRange;
+		}
+		if (result.ec != std::errc() || result.ptr != last)
+		{
+			return NumberParse::NotANumber;
+		}
+
+		// std::stod rejects inexact subnormal results as well. They are
+		// rare, so let strtod make that call for them
+		if (num != 0 && std::fabs(num) < std::numeric_limits<double>::min())
+		{
+			const std::string copy(token);
+			errno = 0;
+			std::strtod(copy.c_str(), nullptr);
+			if (errno == ERANGE)
+			{
+				return NumberParse::OutOfRange;
+			}
+		}
+
+		if (negative)
+		{
+			num = -num;
+		}
+		return NumberParse::Number;
+	}
 }
 
-bool token_to_atom(const std::string & token, Atom & atom)
+bool token_to_atom(std::string_view token, Atom & atom)
 {
 	if (token.empty() || token == " ")
 	{
@@ -148,50 +635,104 @@ bool token_to_atom(const std::string & token, Atom & atom)
 	{
 		atom.type = BooleanType;
 		atom.value.bool_value = true;
+		return true;
 	}
-	else if (token == "False")
+	if (token == "False")
 	{
 		atom.type = BooleanType;
 		atom.value.bool_value = false;
+		return true;
 	}
-	else
+
+	// An array literal is not an atom, and is not a symbol either
+	if (token.compare(0, 2, ARRAY_OPEN) == 0)
 	{
-		// Attempt to parse the token as a double, checking for invalid characters
-		try
-		{
-			std::size_t pos = 0; // Position of the character following the last character interpreted
-			double num = std::stod(token, &pos);
+		return false;
+	}
 
-			// Check if the entire string was consumed, with no leftover characters
-			if (pos != token.size())
-			{
-				// If not all characters were used, it's an invalid number token
-				throw std::invalid_argument("");
-			}
+	// Only tokens with a possible number lead are read as a number
+	double num = 0;
+	NumberParse parsed = NumberParse::NotANumber;
+	if (numberLeads.lead[static_cast<unsigned char>(token[0])])
+	{
+		parsed = parseNumber(token, num);
+	}
+
+	if (parsed == NumberParse::Number)
+	{
+		atom.type = NumberType;
+		atom.value.num_value = num;
+		return true;
+	}
 
-			atom.type = NumberType;
-			atom.value.num_value = num;
+	if (parsed == NumberParse::OutOfRange)
+	{
+		// The number is out of the range of representable values by a double
+		return false;
+	}
+
+	// If it's not a valid number, then it's a symbol
+	// But first, we need to ensure it's a valid symbol (e.g., doesn't start with a digit or isn't a floating point)
+	if (std::isdigit(static_cast<unsigned char>(token[0])) == 0 && token.find('.') == std::string_view::npos)
+	{
+		atom.type = SymbolType;
+		atom.value.sym_value = token;
+		return true;
+	}
+
+	return false; // Invalid token
+}
+
+bool is_array_token(std::string_view token) noexcept
+{
+	return token.size() >= 3 && token.compare(0, 2, ARRAY_OPEN) == 0 && token.back() == ARRAY_CLOSE;
+}
+
+bool token_to_array(std::string_view token, AstArena & arena, Atom & atom)
+{
+	if (!is_array_token(token))
+	{
+		return false;
+	}
+
+	// The elements follow the same syntax as numbers anywhere else. They
+	// are counted first, so they are parsed straight into the arena. A
+	// bad element fails the whole parse, which drops the arena with it
+	const std::string_view body = token.substr(2, token.size() - 3);
+	std::size_t count = 0;
+	for (std::size_t pos = 0; pos < body.size(); ++pos)
+	{
+		if (!isSpace(body[pos]) && (pos == 0 || isSpace(body[pos - 1])))
+		{
+			++count;
 		}
-		catch (const std::invalid_argument&)
+	}
+	Number * data = arena.allocateArray<Number>(count);
+
+	std::size_t pos = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		while (isSpace(body[pos]))
 		{
-			// If it's not a valid number, then it's a symbol
-			// But first, we need to ensure it's a valid symbol (e.g., doesn't start with a digit or isn't a floating point)
-			if (std::isdigit(token[0]) == 0 && token.find('.') == std::string::npos)
-			{
-				atom.type = SymbolType;
-				atom.value.sym_value = token;
-			}
-			else
-			{
-				return false; // Invalid token
-			}
+			++pos;
+		}
+
+		std::size_t end = pos;
+		while (end < body.size() && !isSpace(body[end]))
+		{
+			++end;
 		}
-		catch (const std::out_of_range&)
+
+		if (parseNumber(body.substr(pos, end - pos), data[i]) != NumberParse::Number)
 		{
-			// The number is out of the range of representable values by a double
 			return false;
 		}
+		pos = end;
 	}
-	return true; // Valid token
-}
 
+	atom.type = ArrayType;
+	atom.value.array_value.data = data;
+	atom.value.array_value.size = count;
+	atom.value.array_value.hash = hashNumbers(data, count);
+	return true;
+}
@@ -2,15 +2,24 @@
 #define TYPES_HPP
 
 // system includes
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
 #include <cmath>
 #include <limits>
+#include <utility>
+#include <type_traits>
+
+// module includes
+#include "symbol.hpp"
+#include "ast_arena.hpp"
 
 // A Type is a literal boolean, literal number, or symbol
 enum Type {NoneType, BooleanType, NumberType, ListType, SymbolType,
-	   PointType, LineType, ArcType};
+	   PointType, LineType, ArcType, ArrayType};
 
 // A Boolean is a C++ bool
 typedef bool Boolean;
@@ -18,9 +27,6 @@ typedef bool Boolean;
 // A Number is a C++ double
 typedef double Number;
 
-// A Symbol is a string
-typedef std::string Symbol;
-
 // A Point is two Numbers
 struct Point {
   Number x;
@@ -46,31 +52,122 @@ struct Arc{
   Point start;
   Number span;
 };
+
+// An Array is a packed run of Numbers from a #[...] literal. The Numbers
+// are stored elsewhere, in the arena of the parse that read them or in a
+// block kept by the tail of the Expression holding the array. The hash
+// of the Numbers is computed once, when the array is made, so hashing an
+// array is O(1)
+struct Array{
+  const Number * data;
+  std::size_t size;
+  std::size_t hash;
+};
+
+// the hash of the size Numbers at data, for Array::hash
+std::size_t hashNumbers(const Number * data, std::size_t size) noexcept;
+
+// combine a hash into seed, in the manner of boost::hash_combine
+inline std::size_t mixHash(std::size_t seed, std::size_t value) noexcept
+{
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
   
-// A Value is a boolean, number, or symbol
-// cannot use a union because symbol is non-POD
-// this wastes space but is simple 
-struct Value {
+// A Value is a boolean, number, symbol, geometry or array. Only the
+// member named by the type of its Atom is valid, they share storage
+union Value {
   Boolean bool_value;
   Number num_value;
   Symbol sym_value;
   Point point_value;
   Line line_value;
   Arc arc_value;
+  Array array_value;
+
+  Value() noexcept: num_value(0){};
 };
-  
+
 // An Atom has a type and value
 struct Atom{
   Type type;
   Value value;
 };
 
+// The largest value is an Arc, five Numbers
+static_assert(sizeof(Value) == sizeof(Arc), "Value should be as large as its largest member");
+static_assert(sizeof(Atom) <= sizeof(Arc) + sizeof(Number), "Atom should be its Value and a tag");
+static_assert(std::is_trivially_copyable<Atom>::value, "Atom should copy as plain bytes");
+
+struct Expression;
+
+// An ExpressionList is the tail of an Expression. The tails of a parsed
+// program live in its AstArena and the list only refers to that
+// storage, so copying one is cheap and nothing is freed per node. A list
+// built from a std::vector puts its elements in a reference counted heap
+// block instead. The elements are never changed after that, so copies
+// share the block and copying any list is O(1). That also lets a list
+// keep the hash of its elements, computed once when it is made from
+// the hashes its elements already keep
+class ExpressionList
+{
+public:
+  typedef const Expression * const_iterator;
+
+  ExpressionList() noexcept: items(nullptr), count(0), owned(false), elementsHash(0){};
+  ExpressionList(const std::vector<Expression> & exps);
+  ExpressionList(std::vector<Expression> && exps);
+  ExpressionList(const ExpressionList & list);
+  ExpressionList(ExpressionList && list) noexcept;
+  ExpressionList & operator=(const ExpressionList & list);
+  ExpressionList & operator=(ExpressionList && list) noexcept;
+  ~ExpressionList();
+
+  // a list of count expressions stored elsewhere, which must outlive it.
+  // They must not change afterwards, or the hash of the list goes stale
+  static ExpressionList view(const Expression * items, std::size_t count);
+
+  // an empty list that keeps a reference counted copy of the size
+  // Numbers at data, and sets copy to where that copy is
+  static ExpressionList numbers(const Number * data, std::size_t size, const Number *& copy);
+
+  bool empty() const noexcept { return count == 0; }
+  std::size_t size() const noexcept { return count; }
+
+  // structural hash of the elements, 0 for an empty list. It is kept in
+  // 32 bits beside the count, so an Expression stays 64 bytes
+  std::uint32_t hash() const noexcept { return elementsHash; }
+
+  // the most elements a list can hold, as its count has 31 bits
+  static constexpr std::size_t MAX_SIZE = (std::size_t(1) << 31) - 1;
+
+  const Expression & operator[](std::size_t i) const noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+private:
+  // the reference count in front of the elements of a shared block
+  struct SharedBlock;
+
+  void share(std::size_t bytes);
+  void acquire() const noexcept;
+  void release() noexcept;
+  void rehash() noexcept;
+
+  const Expression * items;
+  std::uint32_t count : 31;
+  std::uint32_t owned : 1;
+  std::uint32_t elementsHash;
+};
+
+static_assert(sizeof(ExpressionList) == sizeof(const Expression *) + 2 * sizeof(std::uint32_t),
+              "ExpressionList should be a pointer, its count and its hash");
+
 // An expression is an atom called the head
 // followed by a (possibly empty) list of expressions
 // called the tail
 struct Expression{
   Atom head;
-  std::vector<Expression> tail;
+  ExpressionList tail;
 
   Expression() 
   {
@@ -83,6 +180,20 @@ struct Expression{
       head.type = SymbolType;
       head.value.sym_value = sym;
   }
+
+  Expression(const Symbol& sym, std::vector<Expression>&& t)
+      : tail(std::move(t))
+  {
+      head.type = SymbolType;
+      head.value.sym_value = sym;
+  }
+
+  Expression(const Symbol& sym, ExpressionList&& t)
+      : tail(std::move(t))
+  {
+      head.type = SymbolType;
+      head.value.sym_value = sym;
+  }
   
   Expression(const Atom & atom): head(atom){};
   Expression(bool tf);
@@ -103,18 +214,95 @@ struct Expression{
 	     std::tuple<double,double> start, 
 	     double angle);
   
+  // Expressions are equal when their heads are equal and their tails
+  // are equal element by element. Numbers, points, lines, arcs and arrays
+  // are compared with a tolerance of one machine epsilon
   bool operator==(const Expression & exp) const noexcept;
+  bool operator!=(const Expression & exp) const noexcept { return !(*this == exp); }
+
+  // Expressions are identical when they are equal bit for bit: numbers
+  // are compared by their bits, so 0 and -0 differ and a NaN matches
+  // itself. Hash based containers use this, with IdenticalExpression
+  bool identical(const Expression & exp) const noexcept;
+
+  // structural hash, consistent with identical() but not with the
+  // tolerance of operator==. It is O(1), as the tail keeps the hash of
+  // its elements
+  std::size_t hash() const noexcept;
+
+  // If this is an array, copy its Numbers into a block the tail keeps,
+  // so the array no longer refers to the arena or environment they were
+  // read into. A value handed out of the interpreter must not
+  void ownNumbers();
+};
+
+
+inline const Expression & ExpressionList::operator[](std::size_t i) const noexcept
+{
+  return items[i];
+}
+
+inline ExpressionList::const_iterator ExpressionList::begin() const noexcept
+{
+  return items;
+}
+
+inline ExpressionList::const_iterator ExpressionList::end() const noexcept
+{
+  return items + count;
+}
+
+// The equality for unordered containers of Expressions, which must
+// agree with std::hash<Expression>:
+//   std::unordered_set<Expression, std::hash<Expression>, IdenticalExpression>
+struct IdenticalExpression
+{
+  bool operator()(const Expression & a, const Expression & b) const noexcept { return a.identical(b); }
 };
 
+namespace std
+{
+  template<> struct hash<Expression>
+  {
+    std::size_t operator()(const Expression & exp) const noexcept { return exp.hash(); }
+  };
+}
+
+// Arguments are the evaluated arguments of a procedure call, a view of
+// atoms stored by the caller, so a call copies and allocates nothing
+class Arguments
+{
+public:
+  typedef const Atom * const_iterator;
+
+  Arguments(const Atom * items, std::size_t count) noexcept: items(items), count(count){};
 
-// A Procedure is a C++ function pointer taking
-// a vector of Atoms as arguments
-typedef Expression (*Procedure)(const std::vector<Atom> & args);
+  bool empty() const noexcept { return count == 0; }
+  std::size_t size() const noexcept { return count; }
+
+  const Atom & operator[](std::size_t i) const noexcept { return items[i]; }
+  const_iterator begin() const noexcept { return items; }
+  const_iterator end() const noexcept { return items + count; }
+
+private:
+  const Atom * items;
+  std::size_t count;
+};
+
+// A Procedure is a C++ function pointer taking the arguments of a call
+// and writing its value to result
+typedef void (*Procedure)(Arguments args, Atom & result);
 
 // format an expression for output
 std::ostream & operator<<(std::ostream & out, const Expression & exp);
 
 // map a token to an Atom
-bool token_to_atom(const std::string & token, Atom & atom);
+bool token_to_atom(std::string_view token, Atom & atom);
+
+// true if token is an array literal, #[ followed by numbers and ]
+bool is_array_token(std::string_view token) noexcept;
+
+// map an array literal token to an Atom whose Numbers are put in arena
+bool token_to_array(std::string_view token, AstArena & arena, Atom & atom);
 
 #endif
@@ -0,0 +1,211 @@
+#include "form_reader.hpp"
+
+// system includes
+#include <cstring>
+
+// module includes
+#include "tokenize.hpp"
+
+namespace
+{
+  const std::size_t CHUNK_SIZE = 64 * 1024;
+
+  bool isSpace(char c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+}
+
+FormReader::FormReader(std::istream & in): in(&in), pos(0)
+{
+}
+
+FormReader::FormReader(std::string_view text) noexcept: in(nullptr), text(text), pos(0)
+{
+}
+
+// Append the next chunk of the stream to pending. Text in memory has
+// nothing more to read
+bool FormReader::fill()
+{
+  if (in == nullptr)
+  {
+    return false;
+  }
+
+  const std::size_t size = pending.size();
+  pending.resize(size + CHUNK_SIZE);
+  in->read(&pending[size], CHUNK_SIZE);
+  pending.resize(size + static_cast<std::size_t>(in->gcount()));
+  text = pending;
+  return pending.size() > size;
+}
+
+bool FormReader::next(std::string & form)
+{
+  std::string_view view;
+  if (!next(view))
+  {
+    return false;
+  }
+  form.assign(view);
+  return true;
+}
+
+bool FormReader::next(std::string_view & form)
+{
+  const std::size_t none = std::string::npos;
+  std::size_t start = none;
+  std::size_t depth = 0;
+  bool comment = false;
+  // inside an array literal, after a character that ends a token, and
+  // after a '#' that starts one
+  bool array = false;
+  bool tokenStart = true;
+  bool hash = false;
+  std::size_t i = pos;
+
+  while (true)
+  {
+    if (i == text.size())
+    {
+      // Drop what has been consumed before reading more, so the buffer
+      // only ever holds the current form
+      if (in != nullptr)
+      {
+        const std::size_t keep = start == none ? i : start;
+        pending.erase(0, keep);
+        text = pending;
+        i -= keep;
+        if (start != none)
+        {
+          start = 0;
+        }
+      }
+
+      if (!fill())
+      {
+        pos = i;
+        if (start == none)
+        {
+          return false;
+        }
+        form = text.substr(start);
+        return true;
+      }
+    }
+
+    const char c = text[i];
+
+    if (comment)
+    {
+      // Skip to the end of the line in one step when it is buffered
+      const void * newline = std::memchr(text.data() + i, '\n', text.size() - i);
+      if (newline == nullptr)
+      {
+        i = text.size();
+        continue;
+      }
+      i = static_cast<const char *>(newline) - text.data();
+      comment = false;
+    }
+    else if (array)
+    {
+      // An array literal runs to its closing bracket, as in the Lexer.
+      // A parenthesis or comment before it ends it unclosed, and is then
+      // read as it is outside an array
+      const std::size_t stop = text.find_first_of(ARRAY_ENDS, i);
+      if (stop == std::string_view::npos)
+      {
+        i = text.size();
+        continue;
+      }
+      i = stop;
+      array = false;
+      if (text[i] != ARRAY_CLOSE)
+      {
+        if (depth == 0)
+        {
+          form = text.substr(start, i - start);
+          pos = i;
+          return true;
+        }
+        continue;
+      }
+      tokenStart = true;
+      if (depth == 0)
+      {
+        form = text.substr(start, i + 1 - start);
+        pos = i + 1;
+        return true;
+      }
+    }
+    else if (start == none)
+    {
+      if (c == COMMENT)
+      {
+        comment = true;
+        continue;
+      }
+      if (!isSpace(c))
+      {
+        start = i;
+        if (c == OPEN)
+        {
+          depth = 1;
+          tokenStart = true;
+        }
+        else if (c == CLOSE)
+        {
+          form = text.substr(i, 1);
+          pos = i + 1;
+          return true;
+        }
+      }
+    }
+    else if (depth == 0)
+    {
+      // A form that is a single token ends at the next delimiter, unless
+      // it is an array literal
+      if (i == start + 1 && text[start] == ARRAY_OPEN[0] && c == ARRAY_OPEN[1])
+      {
+        array = true;
+      }
+      else if (c == OPEN || c == CLOSE || c == COMMENT || isSpace(c))
+      {
+        form = text.substr(start, i - start);
+        pos = i;
+        return true;
+      }
+    }
+    else
+    {
+      // Inside a list, only a "#[" at the start of a token opens an array
+      const bool opensArray = hash && c == ARRAY_OPEN[1];
+      hash = tokenStart && c == ARRAY_OPEN[0];
+      tokenStart = c == OPEN || c == CLOSE || c == COMMENT || isSpace(c);
+
+      if (opensArray)
+      {
+        array = true;
+      }
+      else if (c == COMMENT)
+      {
+        comment = true;
+        continue;
+      }
+      else if (c == OPEN)
+      {
+        ++depth;
+      }
+      else if (c == CLOSE && --depth == 0)
+      {
+        form = text.substr(start, i + 1 - start);
+        pos = i + 1;
+        return true;
+      }
+    }
+
+    ++i;
+  }
+}
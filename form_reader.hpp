@@ -0,0 +1,42 @@
+#ifndef FORM_READER_HPP
+#define FORM_READER_HPP
+
+// system includes
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+// A FormReader reads the top level forms of a program one at a time, so
+// each can be parsed and evaluated before the rest has been read. A top
+// level form is a parenthesized list, with ';' comments inside it, an
+// array literal, or any other single token. Array literals are read as
+// the Lexer reads them, to their closing bracket whatever is in between,
+// inside lists as well. Whitespace and comments between forms are
+// skipped. The program is either a stream, read in chunks and keeping
+// only the text of the form being read, or text already in memory, such
+// as a mapped file, from which forms are handed out without copying
+class FormReader
+{
+public:
+  explicit FormReader(std::istream & in);
+  explicit FormReader(std::string_view text) noexcept;
+
+  // read the next form into form, false at the end of the program. The
+  // view is valid until the next call. A list that is still open at the
+  // end is returned as it is, for the parser to reject
+  bool next(std::string_view & form);
+
+  // same as above, copying the form
+  bool next(std::string & form);
+
+private:
+  bool fill();
+
+  std::istream * in;
+  std::string pending;
+  std::string_view text;
+  std::size_t pos;
+};
+
+#endif
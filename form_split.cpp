@@ -0,0 +1,134 @@
+#include "form_split.hpp"
+
+// system includes
+#include <cstring>
+
+// module includes
+#include "tokenize.hpp"
+
+namespace
+{
+  // The characters that change the parenthesis depth or start a comment
+  struct SplitTable
+  {
+    bool special[256] = {};
+
+    SplitTable()
+    {
+      special[static_cast<unsigned char>(OPEN)] = true;
+      special[static_cast<unsigned char>(CLOSE)] = true;
+      special[static_cast<unsigned char>(COMMENT)] = true;
+    }
+  };
+
+  bool isSpace(char c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  // Skip whitespace and comments from pos
+  std::size_t skipBlank(std::string_view source, std::size_t pos)
+  {
+    while (pos < source.size())
+    {
+      if (source[pos] == COMMENT)
+      {
+        const void * newline = std::memchr(source.data() + pos, '\n', source.size() - pos);
+        if (newline == nullptr)
+        {
+          return source.size();
+        }
+        pos = static_cast<const char *>(newline) - source.data();
+      }
+      else if (!isSpace(source[pos]))
+      {
+        return pos;
+      }
+      ++pos;
+    }
+    return pos;
+  }
+}
+
+bool splitTopLevelForms(std::string_view source, std::size_t pieces, FormSplit & split)
+{
+  const std::size_t size = source.size();
+
+  // The root list and its head token
+  std::size_t pos = skipBlank(source, 0);
+  if (pos == size || source[pos] != OPEN)
+  {
+    return false;
+  }
+  pos = skipBlank(source, pos + 1);
+  if (pos == size || source[pos] == OPEN || source[pos] == CLOSE)
+  {
+    return false;
+  }
+  while (pos < size && source[pos] != OPEN && source[pos] != CLOSE && source[pos] != COMMENT && !isSpace(source[pos]))
+  {
+    ++pos;
+  }
+
+  split.headEnd = pos;
+  split.starts.assign(1, pos);
+
+  // Cut before the first form opening at depth one past each multiple
+  // of step. Only parentheses and comments matter for the depth, so
+  // everything else is skipped with a table lookup
+  static const SplitTable table;
+
+  const std::size_t step = pieces > 1 ? (size - pos) / pieces + 1 : size;
+  std::size_t next = pos + step;
+  std::size_t depth = 1;
+
+  while (true)
+  {
+    while (pos < size && !table.special[static_cast<unsigned char>(source[pos])])
+    {
+      ++pos;
+    }
+    if (pos == size)
+    {
+      break;
+    }
+
+    const char c = source[pos];
+
+    if (c == OPEN)
+    {
+      if (depth == 1 && pos >= next)
+      {
+        split.starts.push_back(pos);
+        next = pos + step;
+      }
+      ++depth;
+    }
+    else if (c == CLOSE)
+    {
+      if (--depth == 0)
+      {
+        break;
+      }
+    }
+    else
+    {
+      const void * newline = std::memchr(source.data() + pos, '\n', size - pos);
+      if (newline == nullptr)
+      {
+        break;
+      }
+      pos = static_cast<const char *>(newline) - source.data();
+    }
+    ++pos;
+  }
+
+  // Unbalanced, or followed by more than blanks
+  if (depth != 0 || skipBlank(source, pos + 1) != size)
+  {
+    return false;
+  }
+  split.close = pos;
+
+  return split.starts.size() > 1;
+}
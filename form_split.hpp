@@ -0,0 +1,32 @@
+#ifndef FORM_SPLIT_HPP
+#define FORM_SPLIT_HPP
+
+// system includes
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Where a program of the form (head form form ...) can be cut into
+// pieces that each hold whole top level forms, so the pieces can be
+// tokenized and parsed independently
+struct FormSplit
+{
+  // offset just past the head token of the root list
+  std::size_t headEnd;
+
+  // offsets where the pieces start, the first one is headEnd and
+  // every piece runs to the start of the next, the last to close
+  std::vector<std::size_t> starts;
+
+  // offset of the parenthesis closing the root list
+  std::size_t close;
+};
+
+// Split source into at most pieces parts of about equal size, cutting
+// only before the top level lists of the root list. Parenthesis depth
+// is tracked outside of comments. Returns false if source is not one
+// well formed list followed by nothing but whitespace and comments, or
+// if it cannot be cut at all
+bool splitTopLevelForms(std::string_view source, std::size_t pieces, FormSplit & split);
+
+#endif
@@ -0,0 +1,142 @@
+#include "hash_cons.hpp"
+
+// system includes
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace
+{
+  std::size_t bitsOf(Number num) noexcept
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, &num, sizeof(bits));
+    return static_cast<std::size_t>(bits);
+  }
+
+  // Numbers compare by their bits, so 0 and -0 stay apart and a NaN
+  // matches itself, and only the value named by the type is read
+  bool sameNumber(Number a, Number b) noexcept
+  {
+    return bitsOf(a) == bitsOf(b);
+  }
+
+  bool samePoint(const Point & a, const Point & b) noexcept
+  {
+    return sameNumber(a.x, b.x) && sameNumber(a.y, b.y);
+  }
+
+  std::size_t hashOf(const Atom & atom) noexcept
+  {
+    std::size_t seed = atom.type;
+    switch (atom.type)
+    {
+    case BooleanType:
+      return mixHash(seed, atom.value.bool_value);
+    case NumberType:
+      return mixHash(seed, bitsOf(atom.value.num_value));
+    case SymbolType:
+      return mixHash(seed, atom.value.sym_value.id());
+    case PointType:
+      seed = mixHash(seed, bitsOf(atom.value.point_value.x));
+      return mixHash(seed, bitsOf(atom.value.point_value.y));
+    case LineType:
+      seed = mixHash(seed, bitsOf(atom.value.line_value.first.x));
+      seed = mixHash(seed, bitsOf(atom.value.line_value.first.y));
+      seed = mixHash(seed, bitsOf(atom.value.line_value.second.x));
+      return mixHash(seed, bitsOf(atom.value.line_value.second.y));
+    case ArcType:
+      seed = mixHash(seed, bitsOf(atom.value.arc_value.center.x));
+      seed = mixHash(seed, bitsOf(atom.value.arc_value.center.y));
+      seed = mixHash(seed, bitsOf(atom.value.arc_value.start.x));
+      seed = mixHash(seed, bitsOf(atom.value.arc_value.start.y));
+      return mixHash(seed, bitsOf(atom.value.arc_value.span));
+    case ArrayType:
+      seed = mixHash(seed, std::hash<const Number *>()(atom.value.array_value.data));
+      return mixHash(seed, atom.value.array_value.size);
+    default:
+      return seed;
+    }
+  }
+
+  bool sameAtom(const Atom & a, const Atom & b) noexcept
+  {
+    if (a.type != b.type)
+    {
+      return false;
+    }
+    switch (a.type)
+    {
+    case BooleanType:
+      return a.value.bool_value == b.value.bool_value;
+    case NumberType:
+      return sameNumber(a.value.num_value, b.value.num_value);
+    case SymbolType:
+      return a.value.sym_value == b.value.sym_value;
+    case PointType:
+      return samePoint(a.value.point_value, b.value.point_value);
+    case LineType:
+      return samePoint(a.value.line_value.first, b.value.line_value.first) &&
+        samePoint(a.value.line_value.second, b.value.line_value.second);
+    case ArcType:
+      return samePoint(a.value.arc_value.center, b.value.arc_value.center) &&
+        samePoint(a.value.arc_value.start, b.value.arc_value.start) &&
+        sameNumber(a.value.arc_value.span, b.value.arc_value.span);
+    case ArrayType:
+      // each array literal has numbers of its own, so arrays are the
+      // same only when they are the same literal
+      return a.value.array_value.data == b.value.array_value.data &&
+        a.value.array_value.size == b.value.array_value.size;
+    default:
+      return true;
+    }
+  }
+}
+
+std::size_t HashConsTable::hashOf(const Expression * items, std::size_t count) noexcept
+{
+  std::size_t seed = count;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    seed = mixHash(seed, ::hashOf(items[i].head));
+    seed = mixHash(seed, std::hash<const Expression *>()(items[i].tail.begin()));
+    seed = mixHash(seed, items[i].tail.size());
+  }
+  return seed;
+}
+
+bool HashConsTable::equal(const Expression * a, const Expression * b, std::size_t count) noexcept
+{
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (!sameAtom(a[i].head, b[i].head) || a[i].tail.begin() != b[i].tail.begin() ||
+      a[i].tail.size() != b[i].tail.size())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+const Expression * HashConsTable::intern(Expression * items, std::size_t count, AstArena & arena)
+{
+  const std::size_t hash = hashOf(items, count);
+  auto range = tails.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (it->second.count == count && equal(it->second.items, items, count))
+    {
+      ++shared;
+      return it->second.items;
+    }
+  }
+
+  Expression * tail = arena.allocateArray<Expression>(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    new (tail + i) Expression(std::move(items[i]));
+  }
+  tails.emplace(hash, Tail{ tail, count });
+  return tail;
+}
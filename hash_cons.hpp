@@ -0,0 +1,44 @@
+#ifndef HASH_CONS_HPP
+#define HASH_CONS_HPP
+
+// system includes
+#include <cstddef>
+#include <unordered_map>
+
+// module includes
+#include "expression.hpp"
+#include "ast_arena.hpp"
+
+// A HashConsTable keeps one copy of every distinct tail built by a
+// parse, so structurally identical subtrees share their nodes. Tails are
+// interned bottom up: the children of a new tail have already been
+// interned, so two subtrees are equal exactly when their heads are equal
+// and their tails are the same storage. Comparing a tail is then one
+// level deep, and a shared tail identifies its subtree by address
+class HashConsTable
+{
+public:
+  // a tail in arena equal to the count expressions at items, an existing
+  // one if an equal tail was interned before. The expressions at items
+  // are moved from when a new tail is made
+  const Expression * intern(Expression * items, std::size_t count, AstArena & arena);
+
+  // tails interned and tails that were found already interned
+  std::size_t tailCount() const noexcept { return tails.size(); }
+  std::size_t sharedCount() const noexcept { return shared; }
+
+private:
+  struct Tail
+  {
+    const Expression * items;
+    std::size_t count;
+  };
+
+  static std::size_t hashOf(const Expression * items, std::size_t count) noexcept;
+  static bool equal(const Expression * a, const Expression * b, std::size_t count) noexcept;
+
+  std::unordered_multimap<std::size_t, Tail> tails;
+  std::size_t shared = 0;
+};
+
+#endif
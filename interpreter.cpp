@@ -5,12 +5,20 @@
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
 
 // module includes
 #include "tokenize.hpp"
 #include "expression.hpp"
 #include "environment.hpp"
 #include "interpreter_semantic_error.hpp"
+#include "mapped_file.hpp"
+#include "program_file.hpp"
+#include "form_split.hpp"
+#include "small_vector.hpp"
+#include "text_hash.hpp"
 
 
 //class constructor
@@ -25,22 +33,96 @@ bool Interpreter::parse(std::istream & expression) noexcept
         return false;
     }
 
-    TokenSequenceType tokens = tokenize(expression);
-    auto iter = tokens.begin();
-    if (iter == tokens.end())
+    // Read the whole stream once so the tokens can be views into it
+    std::string source((std::istreambuf_iterator<char>(expression)), std::istreambuf_iterator<char>());
+    return parse(source);
+}
+
+bool Interpreter::parse(std::string_view source) noexcept
+{
+    return parseSource(source, true);
+}
+
+// Parse source, looking it up in the cache and adding it there only if
+// cacheable
+bool Interpreter::parseSource(std::string_view source, bool cacheable) noexcept
+{
+    clearResolved();
+
+    //check if the first character is open paranthesis '('
+    if (source.empty() || (source.front() != '(' && source.front() != ';'))
+    {
+        return false;
+    }
+
+    // Identical input gets the AST that was built for it before. The
+    // source is only hashed when the cache is on
+    const bool caching = cacheable && cache.enabled();
+    ParseCache::Key key{};
+    if (caching)
+    {
+        key = ParseCache::keyOf(source);
+        ParseCache::Entry cached;
+        if (cache.find(key, source, cached))
+        {
+            ast = cached.ast;
+            astArena = cached.arena;
+            return true;
+        }
+    }
+
+    // The new program is built in a fresh arena, which replaces the
+    // arena of the previous program in one step
+    std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
+
+    // Large programs are parsed form by form. Anything the split or the
+    // forms reject is parsed again below, so errors are found the same
+    // way for every input
+    if (source.size() >= FORM_PARSE_MIN)
+    {
+        try
+        {
+            Expression program;
+            if (parseForms(source, arena, program))
+            {
+                ast = std::move(program);
+                astArena = std::move(arena);
+                if (caching)
+                {
+                    cache.insert(key, source, { astArena, ast });
+                }
+                return true;
+            }
+        }
+        catch (...)
+        {
+        }
+        arena = std::make_shared<AstArena>();
+    }
+
+    // Tokens are pulled from the lexer as the parser needs them
+    Lexer lexer(source);
+    if (lexer.atEnd())
     {
         return false; // Empty input
     }
 
     try
     {
-        ast = parseExpression(iter, tokens.end());
+        HashConsTable table;
+        ast = parseExpression(lexer, *arena, hashConsing ? &table : nullptr);
+        astArena = std::move(arena);
 
         // After successfully parsing an expression, there should be no tokens left.
-        if (iter != tokens.end())
+        if (!lexer.atEnd())
         {
             return false; // Extra tokens found
         }
+
+        if (caching)
+        {
+            cache.insert(key, source, { astArena, ast });
+        }
     }
     catch (...)
     {
@@ -50,221 +132,727 @@ bool Interpreter::parse(std::istream & expression) noexcept
     return true;
 }
 
-Expression Interpreter::eval()
+// Parse the top level forms of source one span at a time, where a span
+// runs from one list at depth one to the next. Spans whose text is the
+// same as one of the last program parsed this way get the forms parsed
+// then, so only the changed spans are tokenized and parsed. When there is
+// enough text to parse, the changed spans are split between threads,
+// each with an arena of its own that the arena of the program adopts at
+// the end
+bool Interpreter::parseForms(std::string_view source, const std::shared_ptr<AstArena> & arena, Expression & program)
 {
-    if (ast.head.type == NoneType)
+    FormSplit split;
+    if (!splitTopLevelForms(source, source.size(), split))
     {
-        throw InterpreterSemanticError("Error: No AST to evaluate.");
+        return false;
     }
 
-    return evaluateExpression(ast);
-}
+    // The root list is "(" and a symbol
+    Lexer headLexer(source.substr(0, split.headEnd));
+    headLexer.next();
+    Atom head;
+    if (!token_to_atom(headLexer.next(), head) || head.type != SymbolType)
+    {
+        return false;
+    }
 
-/*
- * Parses and constructs an Expression from a sequence of tokens.
- *
- * This function is responsible for recursively parsing tokens to build a structured
- * Expression object. It handles different types of tokens, including atomic values,
- * parentheses, and operations. If encountered, it validates the token sequence and
- * constructs an Expression accordingly.
- */
-Expression Interpreter::parseExpression(TokenIteratorType& token, TokenIteratorType end)
-{
-    if (token == end)
+    struct Span
     {
-        throw InterpreterSemanticError("Error: unexpected end of input.");
+        std::string_view text;
+        std::size_t offset;
+        TextHash hash;
+        const FormSpan * reused;
+        std::size_t group;
+        std::size_t first;
+        std::size_t count;
+        std::size_t bytes;
+    };
+
+    const std::size_t count = split.starts.size();
+    std::vector<Span> spans(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Span & span = spans[i];
+        const std::size_t end = i + 1 < count ? split.starts[i + 1] : split.close;
+        span.offset = split.starts[i];
+        span.text = source.substr(span.offset, end - span.offset);
+        span.hash = TextHash(span.text);
+        span.reused = nullptr;
     }
-    std::string currentToken = *token; // Safe dereferencing
 
-    if (currentToken == "(")
+    // An edit leaves the spans before and after it as they were, so the
+    // old spans are matched from the front and from the back. TextHash is
+    // not collision resistant, so hashes only rule spans out: a span is
+    // the same if its text is
+    const std::string_view oldSource = formSource;
+    auto same = [oldSource](const Span & span, const FormSpan & formSpan)
+    {
+        return span.hash == formSpan.hash && span.text.size() == formSpan.length
+            && span.text == oldSource.substr(formSpan.offset, formSpan.length);
+    };
+
+    std::size_t reusedBytes = 0;
+    std::size_t prefix = 0;
+    while (prefix < count && prefix < formSpans.size() && same(spans[prefix], formSpans[prefix]))
     {
-        ++token;
-        if (token == end || *token == ")")
+        spans[prefix].reused = &formSpans[prefix];
+        reusedBytes += formSpans[prefix].bytes;
+        ++prefix;
+    }
+    std::size_t suffix = 0;
+    while (prefix + suffix < count && prefix + suffix < formSpans.size()
+           && same(spans[count - 1 - suffix], formSpans[formSpans.size() - 1 - suffix]))
+    {
+        spans[count - 1 - suffix].reused = &formSpans[formSpans.size() - 1 - suffix];
+        reusedBytes += formSpans[formSpans.size() - 1 - suffix].bytes;
+        ++suffix;
+    }
+
+    // Forms moved around within the edited part are found by hash
+    if (prefix + suffix < count && prefix + suffix < formSpans.size())
+    {
+        std::unordered_map<std::size_t, std::size_t> moved;
+        for (std::size_t i = prefix; i + suffix < formSpans.size(); ++i)
         {
-            throw InterpreterSemanticError("Error: empty expression.");
+            moved.emplace(formSpans[i].hash.value(), i);
         }
-        currentToken = *token;
+        for (std::size_t i = prefix; i + suffix < count; ++i)
+        {
+            auto found = moved.find(spans[i].hash.value());
+            if (found != moved.end() && same(spans[i], formSpans[found->second]))
+            {
+                spans[i].reused = &formSpans[found->second];
+                reusedBytes += formSpans[found->second].bytes;
+            }
+        }
+    }
+
+    // Reused forms keep the old arena alive. Once it holds more forms
+    // that are gone than forms still in use, everything is parsed again
+    // so it can be freed
+    const bool reuse = formArena != nullptr && formArena->bytesUsed() <= 2 * reusedBytes;
+
+    std::vector<std::size_t> changed;
+    std::size_t changedLength = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!reuse)
+        {
+            spans[i].reused = nullptr;
+        }
+        if (spans[i].reused == nullptr)
+        {
+            changed.push_back(i);
+            changedLength += spans[i].text.size();
+        }
+    }
 
-        Atom potentialAtom;
+    // Changed spans are split into groups of about equal length, one
+    // group per thread
+    struct Group
+    {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        AstArena arena;
+        HashConsTable table;
+        std::vector<Expression> forms;
+        bool parsed = false;
+    };
+
+    unsigned threads = parseThreads != 0 ? parseThreads : std::thread::hardware_concurrency();
+    const std::size_t groupCount = changedLength >= PARALLEL_PARSE_MIN && threads > 1 ? threads : 1;
+    std::vector<Group> groups(groupCount);
 
-        if (!token_to_atom(currentToken, potentialAtom))
+    const std::size_t groupLength = changedLength / groupCount + 1;
+    std::size_t length = 0;
+    std::size_t group = 0;
+    for (std::size_t k = 0; k < changed.size(); ++k)
+    {
+        spans[changed[k]].group = group;
+        groups[group].end = k + 1;
+        length += spans[changed[k]].text.size();
+        if (length >= groupLength * (group + 1) && group + 1 < groupCount)
         {
-            throw InterpreterSemanticError("Error: Invalid token");
+            ++group;
+            groups[group].begin = k + 1;
+            groups[group].end = k + 1;
         }
+    }
 
-        if (token_to_atom(currentToken, potentialAtom))
+    auto parseGroup = [this, &spans, &changed](Group & group)
+    {
+        try
         {
-            // If it's an atomic expression like True, False, or a number, return it
-            if (potentialAtom.type == BooleanType || potentialAtom.type == NumberType)
+            for (std::size_t k = group.begin; k < group.end; ++k)
             {
-                ++token;
-                if (token == end || *token != ")")
+                Span & span = spans[changed[k]];
+                const std::size_t bytes = group.arena.bytesUsed();
+                span.first = group.forms.size();
+
+                Lexer lexer(span.text);
+                while (!lexer.atEnd())
                 {
-                    throw InterpreterSemanticError("Error: expected closing parenthesis after atomic expression.");
+                    group.forms.push_back(parseExpression(lexer, group.arena, hashConsing ? &group.table : nullptr));
                 }
-                ++token;
-                return Expression(potentialAtom);
+
+                span.count = group.forms.size() - span.first;
+                span.bytes = group.arena.bytesUsed() - bytes;
             }
+            group.parsed = true;
+        }
+        catch (...)
+        {
         }
-        ++token;
+    };
 
-        //Continue parsing the operands for this operation
-        std::vector<Expression> operands;
-        while (token != end && *token != ")")
+    // The calling thread takes the first group, and any group left over
+    // when no more threads can be started
+    std::vector<std::thread> workers;
+    std::size_t started = 1;
+    try
+    {
+        workers.reserve(groupCount - 1);
+        for (; started < groupCount; ++started)
         {
-            operands.push_back(parseExpression(token, end));
+            workers.emplace_back(parseGroup, std::ref(groups[started]));
         }
+    }
+    catch (...)
+    {
+    }
+    parseGroup(groups[0]);
+    for (std::size_t i = started; i < groupCount; ++i)
+    {
+        parseGroup(groups[i]);
+    }
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
 
-        if (token == end)
+    for (const Group & group : groups)
+    {
+        if (!group.parsed)
         {
-            throw InterpreterSemanticError("Error: expected closing parenthesis.");
+            return false;
         }
+    }
 
-        ++token;
-        return Expression(currentToken, operands);
+    // Put the forms together in source order and remember where each
+    // span's forms are for the next parse
+    std::size_t formCount = 0;
+    for (const Span & span : spans)
+    {
+        formCount += span.reused != nullptr ? span.reused->count : span.count;
     }
 
-    if (currentToken != ")")
+    std::vector<Expression> programForms;
+    programForms.reserve(formCount);
+    std::vector<FormSpan> programSpans(count);
+    for (std::size_t i = 0; i < count; ++i)
     {
-        Atom atom;
-        if (!token_to_atom(currentToken, atom))
+        const Span & span = spans[i];
+        FormSpan & formSpan = programSpans[i];
+        formSpan.hash = span.hash;
+        formSpan.offset = span.offset;
+        formSpan.length = span.text.size();
+        formSpan.first = programForms.size();
+
+        if (span.reused != nullptr)
         {
-            throw InterpreterSemanticError("Error: invalid token.");
+            programForms.insert(programForms.end(), forms.begin() + span.reused->first, forms.begin() + span.reused->first + span.reused->count);
+            formSpan.count = span.reused->count;
+            formSpan.bytes = span.reused->bytes;
         }
-        ++token;
-        return Expression(atom);
+        else
+        {
+            std::vector<Expression> & parsed = groups[span.group].forms;
+            std::move(parsed.begin() + span.first, parsed.begin() + span.first + span.count, std::back_inserter(programForms));
+            formSpan.count = span.count;
+            formSpan.bytes = span.bytes;
+        }
+    }
+
+    for (Group & group : groups)
+    {
+        arena->adopt(std::move(group.arena));
     }
+    if (reuse && changed.size() < count)
+    {
+        arena->retain(formArena);
+    }
+
+    // The root tail lives in the arena too, so the cache and the caller
+    // copy the program without copying its forms
+    Expression* tail = arena->allocateArray<Expression>(programForms.size());
+    std::uninitialized_copy(programForms.begin(), programForms.end(), tail);
+    program = Expression(head.value.sym_value, ExpressionList::view(tail, programForms.size()));
 
-    throw InterpreterSemanticError("Error: Failed to parse.");
+    forms = std::move(programForms);
+    formSpans = std::move(programSpans);
+    formSource.assign(source.data(), source.size());
+    formArena = arena;
+
+    return true;
 }
 
-/**
+void Interpreter::saveProgram(std::ostream & out) const
+{
+    writeProgram(out, ast);
+}
+
+bool Interpreter::loadProgram(const std::string & filename) noexcept
+{
+    try
+    {
+        MappedFile file(filename);
+        return file.isOpen() && loadProgram(file.data());
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool Interpreter::loadProgram(std::string_view image) noexcept
+{
+    clearResolved();
+
+    try
+    {
+        // The nodes are read straight from the image into a new arena
+        std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
+        Expression program;
+        if (!readProgram(image, *arena, program))
+        {
+            return false;
+        }
+
+        ast = std::move(program);
+        astArena = std::move(arena);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool Interpreter::parseFile(const std::string & filename) noexcept
+{
+    try
+    {
+        // Nothing in the AST refers to the source text, so the mapping is
+        // only needed while parsing
+        MappedFile file(filename);
+        return parseFile(file);
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool Interpreter::parseFile(const MappedFile & file) noexcept
+{
+    if (!file.isOpen())
+    {
+        return false;
+    }
+    if (isProgramFile(file.data()))
+    {
+        return loadProgram(file.data());
+    }
+    // Mapped text is parsed in place and never cached, so no copy of it
+    // is made
+    return parseSource(file.data(), false);
+}
+
+Expression Interpreter::eval()
+{
+    if (ast.head.type == NoneType)
+    {
+        throw InterpreterSemanticError("Error: No AST to evaluate.");
+    }
+
+    // Names are bound to slots once per program and environment, so
+    // evaluation does no lookups by name, and with folding what the
+    // program computes from constants is computed there too
+    if (resolved.empty())
+    {
+        resolveProgram(ast, env, resolved, hashConsing, astArena ? astArena->bytesUsed() / sizeof(Expression) + 1 : 0);
+        foldedCount = folding ? foldProgram(ast, env, resolved, hashConsing, foldReporting ? &folded : nullptr) : 0;
+    }
+
+    // A node compiles to about one instruction, so the code is sized
+    // from the resolved nodes up front
+    Expression result;
+    if (evaluator == Evaluator::Bytecode)
+    {
+        Bytecode bytecode;
+        bytecode.code.reserve(resolved.nodes.size() + 1);
+        compileBytecode(resolved, env, bytecode);
+        result = runBytecode(bytecode, env);
+    }
+    else
+    {
+        result = evaluateNode(resolved, resolved.root());
+    }
+
+    // An array may still be in the arena of the program, which the next
+    // parse or the interpreter itself frees, so the result keeps a copy
+    result.ownNumbers();
+    return result;
+}
+
+/*
  * Parses and constructs an Expression from a sequence of tokens.
  *
- * This function is responsible for recursively parsing tokens to build a structured
- * Expression object. It handles different types of tokens, including atomic values,
- * parentheses, and operations. If encountered, it validates the token sequence and
- * constructs an Expression accordingly.
+ * This function parses tokens to build a structured Expression object. It handles
+ * different types of tokens, including atomic values, parentheses, and operations.
+ * Tokens are pulled from the lexer one at a time, so the token sequence is never
+ * stored. Open lists are kept on an explicit stack instead of the call stack, so
+ * nesting depth is only limited by memory. The operands of each list are moved
+ * into one contiguous array in the arena, so the tree is built with pointer-bump
+ * allocations and freed with the arena instead of node by node. With a hash-consing
+ * table, an array equal to one built before is reused instead, so repeated
+ * subexpressions share one node. If encountered, it validates the token sequence and constructs an
+ * Expression accordingly.
  */
-Expression Interpreter::evaluateExpression(const Expression& expr)
+Expression Interpreter::parseExpression(Lexer& lexer, AstArena& arena, HashConsTable* table)
 {
-    // If the expression is atomic (has no tail):
-    if (expr.tail.empty())
+    // A list whose head has been read and whose operands are still being
+    // parsed. Its operands are the entries of operands from first on
+    struct OpenList
     {
-        // If the head is a symbol:
-        if (expr.head.type == SymbolType)
+        Symbol head;
+        std::size_t first;
+    };
+
+    // Most programs nest only a few lists deep, so both stacks usually
+    // stay in their inline storage
+    SmallVector<OpenList, 16> openLists;
+    SmallVector<Expression, 32> operands;
+
+    while (true)
+    {
+        Expression completed;
+
+        if (!openLists.empty() && !lexer.atEnd() && lexer.peek() == ")")
         {
-            return env.get(expr.head.value.sym_value);
+            // Close the innermost list and move its operands into it
+            lexer.next();
+            const OpenList list = openLists.back();
+            openLists.pop_back();
+
+            const std::size_t count = operands.size() - list.first;
+            const Expression* tail;
+            if (table != nullptr)
+            {
+                tail = table->intern(operands.data() + list.first, count, arena);
+            }
+            else
+            {
+                Expression* items = arena.allocateArray<Expression>(count);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    new (items + i) Expression(std::move(operands[list.first + i]));
+                }
+                tail = items;
+            }
+            operands.truncate(list.first);
+            completed = Expression(list.head, ExpressionList::view(tail, count));
         }
-        return expr;  // If the head isn't a symbol
-    }
-    // If the expression is not atomic (has a tail):
-    if (!expr.tail.empty())
-    {
-        // The head should be an operation or procedure.
-        if (expr.head.type == SymbolType)
+        else
         {
-            std::string symbol = expr.head.value.sym_value;
+            if (lexer.atEnd())
+            {
+                if (!openLists.empty())
+                {
+                    throw InterpreterSemanticError("Error: expected closing parenthesis.");
+                }
+                throw InterpreterSemanticError("Error: unexpected end of input.");
+            }
+            TokenView currentToken = lexer.next();
 
-            // Special handling for special forms
-            if (symbol == "if")
+            if (currentToken == "(")
             {
-                if (expr.tail.size() != 3)
+                if (lexer.atEnd() || lexer.peek() == ")")
                 {
-                    throw InterpreterSemanticError("Error: Incorrect number of arguments for 'if'.");
+                    throw InterpreterSemanticError("Error: empty expression.");
                 }
-                Expression condition = evaluateExpression(expr.tail[0]);
-                if (condition.head.type != BooleanType)
+                currentToken = lexer.next();
+
+                Atom potentialAtom;
+
+                if (!token_to_atom(currentToken, potentialAtom))
                 {
-                    throw InterpreterSemanticError("Error: Conditional in 'if' is not a boolean.");
+                    throw InterpreterSemanticError("Error: Invalid token");
                 }
-                if (condition.head.value.bool_value)
+
+                // If it's an atomic expression like True, False, or a number, it is complete
+                if (potentialAtom.type == BooleanType || potentialAtom.type == NumberType)
                 {
-                    return evaluateExpression(expr.tail[1]);
+                    if (lexer.atEnd() || lexer.peek() != ")")
+                    {
+                        throw InterpreterSemanticError("Error: expected closing parenthesis after atomic expression.");
+                    }
+                    lexer.next();
+                    completed = Expression(potentialAtom);
                 }
-                if (!condition.head.value.bool_value)
+                else
                 {
-                    return evaluateExpression(expr.tail[2]);
+                    //Continue with the operands for this operation
+                    openLists.push_back({ potentialAtom.value.sym_value, operands.size() });
+                    continue;
                 }
             }
-            else if (symbol == "begin")
+            else if (is_array_token(currentToken))
             {
-                if (expr.tail.empty())
-                {
-                    throw InterpreterSemanticError("Error: 'begin' requires at least one argument.");
-                }
-                Expression lastExpr;
-                for (const auto& e : expr.tail)
+                // The numbers of an array literal go straight into the arena
+                Atom atom;
+                if (!token_to_array(currentToken, arena, atom))
                 {
-                    lastExpr = evaluateExpression(e);
+                    throw InterpreterSemanticError("Error: invalid array literal.");
                 }
-                return lastExpr;
+                completed = Expression(atom);
             }
-            else if (symbol == "define")
+            else if (currentToken != ")")
             {
-                if (expr.tail.size() != 2 || expr.tail[0].head.type != SymbolType)
+                Atom atom;
+                if (!token_to_atom(currentToken, atom))
                 {
-                    throw InterpreterSemanticError("Error: Incorrect use of 'define'.");
+                    throw InterpreterSemanticError("Error: invalid token.");
                 }
+                completed = Expression(atom);
+            }
+            else
+            {
+                throw InterpreterSemanticError("Error: Failed to parse.");
+            }
+        }
 
-                // Extract the symbol string from the first item in the tail.
-                std::string variable = expr.tail[0].head.value.sym_value;
+        if (openLists.empty())
+        {
+            return completed;
+        }
+        operands.push_back(std::move(completed));
+    }
+}
 
-                if (isSymbolStringDefined(variable))
-                {
-                    throw InterpreterSemanticError("Error: Variable already exists");
-                }
+/**
+ * Parses and constructs an Expression from a sequence of tokens.
+ *
+ * This function is responsible for recursively parsing tokens to build a structured
+ * Expression object. It handles different types of tokens, including atomic values,
+ * parentheses, and operations. If encountered, it validates the token sequence and
+ * constructs an Expression accordingly.
+ */
+Expression Interpreter::evaluateExpression(const Expression& expr)
+{
+    ResolvedProgram program;
+    resolveProgram(expr, env, program);
+    return evaluateNode(program, program.root());
+}
+
+// Evaluate a resolved node. Special forms were told apart and names
+// bound to slots when the program was resolved, so this only dispatches
+// on the form. Nodes whose children are being evaluated are kept on an
+// explicit stack, and their values on another, so any program that can
+// be resolved can be evaluated without running out of call stack
+Expression Interpreter::evaluateNode(const ResolvedProgram& program, const ResolvedNode& root)
+{
+    // A node whose children are being evaluated, and the step it is at:
+    // one before each child and one after the last
+    struct OpenNode
+    {
+        const ResolvedNode* node;
+        std::uint32_t step;
+    };
+    std::vector<OpenNode> open;
+    std::vector<Expression> values;
+
+    // Push the value of a node without children, or open the node
+    auto enter = [&](const ResolvedNode& node)
+    {
+        switch (node.form)
+        {
+        case Form::Constant:
+            values.push_back(*node.constant);
+            return;
+        case Form::Variable:
+            values.push_back(env.get(node.operand));
+            return;
+        case Form::Define:
+        case Form::DefineReserved:
+            if (env.lookup(node.operand) != nullptr)
+            {
+                throw InterpreterSemanticError("Error: Variable already exists");
+            }
+            if (node.form == Form::DefineReserved)
+            {
+                throw InterpreterSemanticError(resolveErrorMessage(DEFINE_RESERVED));
+            }
+            open.push_back({ &node, 0 });
+            return;
+        case Form::If:
+        case Form::Begin:
+        case Form::Call:
+            open.push_back({ &node, 0 });
+            return;
+        case Form::Invalid:
+            break;
+        }
+        throw InterpreterSemanticError(resolveErrorMessage(node.operand));
+    };
 
-                std::string symbol_to_define = expr.tail[0].head.value.sym_value;
-                std::vector<std::string> specialForms = { "define", "if", "begin" };
-                std::vector<std::string> builtInSymbols = { "pi", "+", "-", "*", "/" };
+    enter(root);
+    while (!open.empty())
+    {
+        // Entering a child can move the stack, so the step is taken first
+        OpenNode& top = open.back();
+        const ResolvedNode& node = *top.node;
+        const std::uint32_t step = top.step++;
 
-                if ((std::find(specialForms.begin(), specialForms.end(), symbol_to_define) != specialForms.end()) || (std::find(builtInSymbols.begin(), builtInSymbols.end(), symbol_to_define) != builtInSymbols.end()))
+        switch (node.form)
+        {
+        case Form::If:
+            if (step == 0)
+            {
+                enter(program.child(node, 0));
+            }
+            else if (step == 1)
+            {
+                const Atom& condition = values.back().head;
+                if (condition.type != BooleanType)
                 {
-                    throw InterpreterSemanticError("Error: Cannot redefine special form or built-in symbol.");
+                    throw InterpreterSemanticError("Error: Conditional in 'if' is not a boolean.");
                 }
-
-                Expression value = evaluateExpression(expr.tail[1]);
-                env.addSymbol(symbol_to_define, value);
-                return value;
+                const bool taken = condition.value.bool_value;
+                values.pop_back();
+                enter(program.child(node, taken ? 1 : 2));
             }
             else
             {
-                // For other symbols, evaluate as procedures
-                std::vector<Expression> args;
-                for (const auto& e : expr.tail)
+                open.pop_back();
+            }
+            break;
+        case Form::Begin:
+            if (step < node.children.count)
+            {
+                // Only the value of the last child is kept
+                if (step > 0)
                 {
-                    args.push_back(evaluateExpression(e));
+                    values.pop_back();
                 }
-                return env.evaluateProcedure(symbol, args);
+                enter(program.child(node, step));
             }
-        }
-        else
+            else
+            {
+                if (node.children.count == 0)
+                {
+                    values.emplace_back();
+                }
+                open.pop_back();
+            }
+            break;
+        case Form::Define:
+            if (step == 0)
+            {
+                enter(program.child(node, 1));
+            }
+            else
+            {
+                // The value left is the one the environment keeps, so an
+                // array refers to the copy of its numbers the binding owns
+                env.addSymbol(node.operand, std::move(values.back()));
+                values.back() = *env.lookup(node.operand);
+                open.pop_back();
+            }
+            break;
+        case Form::Call:
         {
-            throw InterpreterSemanticError("Error: Head of expression is not a symbol.");
+            // Procedures only take atoms, so constant and variable arguments
+            // are read in place instead of being entered
+            std::uint32_t next = step;
+            const Expression* value = nullptr;
+            for (; next < node.children.count; ++next)
+            {
+                const ResolvedNode& arg = program.child(node, next);
+                if (arg.form == Form::Constant)
+                {
+                    values.emplace_back(arg.constant->head);
+                }
+                else if (arg.form == Form::Variable && (value = env.lookup(arg.operand)) != nullptr)
+                {
+                    values.emplace_back(value->head);
+                }
+                else
+                {
+                    break;
+                }
+            }
+            if (next < node.children.count)
+            {
+                top.step = next + 1;
+                enter(program.child(node, next));
+                break;
+            }
+
+            // Short calls keep their arguments inline, off the heap, and
+            // the procedure writes its value straight into the result
+            const std::size_t first = values.size() - node.children.count;
+            SmallVector<Atom, 8> args;
+            args.reserve(node.children.count);
+            for (std::size_t i = first; i < values.size(); ++i)
+            {
+                args.push_back(values[i].head);
+            }
+            values.resize(first);
+            values.emplace_back();
+            env.evaluateProcedure(node.operand, args.data(), args.size(), values.back().head);
+            open.pop_back();
+            break;
+        }
+        default:
+            open.pop_back();
+            break;
         }
     }
+    return std::move(values.back());
+}
+
+// Forget the program resolved for the last AST or environment, and what
+// was folded in it. The folded nodes refer to the AST, which may be gone
+void Interpreter::clearResolved() noexcept
+{
+    resolved.clear();
+    folded.clear();
+    foldedCount = 0;
+}
+
+// Forget the forms kept for the next parse, so it parses all of them
+void Interpreter::clearForms() noexcept
+{
+    formSource.clear();
+    formSpans.clear();
+    forms.clear();
+    formArena.reset();
 }
 
 // Reset environment to its default state
 void Interpreter::resetEnvironment()
 {
     env = Environment();
+    env.setMemoCapacity(memoEntries);
+    clearResolved();
 }
 
 //Checks if a variable already exists in our environment
 //returns true if variable exists and false otherwise. 
-bool Interpreter::isSymbolStringDefined(std::string variable)
+bool Interpreter::isSymbolStringDefined(const std::string & variable)
 {
-    // Check if the symbol string is in the envmap.
-    try
-    {
-        Expression test = env.get(variable);
-    }
-    catch (...)
-    {
-        return false;
-    }
-
-    return true;
+    // Check if the symbol string is bound to an expression in the envmap.
+    return env.lookup(variable) != nullptr;
 }
\ No newline at end of file
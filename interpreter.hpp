@@ -3,14 +3,25 @@
 
 // system includes
 #include <string>
+#include <string_view>
 #include <istream>
+#include <ostream>
 #include <vector>
+#include <memory>
 
 
 // module includes
 #include "expression.hpp"
 #include "environment.hpp"
 #include "tokenize.hpp"
+#include "ast_arena.hpp"
+#include "parse_cache.hpp"
+#include "hash_cons.hpp"
+#include "bytecode.hpp"
+#include "resolver.hpp"
+#include "optimizer.hpp"
+#include "mapped_file.hpp"
+#include "text_hash.hpp"
 
 // Interpreter has
 // Environment, which starts at a default
@@ -19,18 +30,138 @@
 class Interpreter{
 public:
   bool parse(std::istream & expression) noexcept;
+  bool parse(std::string_view source) noexcept;
+
+  // write the parsed program in the compiled (.slc) format
+  void saveProgram(std::ostream & out) const;
+  // load a compiled program by mapping the file, in place of parse
+  bool loadProgram(const std::string & filename) noexcept;
+  bool loadProgram(std::string_view image) noexcept;
+
+  // map a file and parse the source or load the compiled program in
+  // it, straight from the mapped pages
+  bool parseFile(const std::string & filename) noexcept;
+  // the same for a file mapped already, so a caller can tell a file that
+  // does not open from one that does not parse
+  bool parseFile(const MappedFile & file) noexcept;
   Expression eval();
 
-  typedef TokenSequenceType::iterator TokenIteratorType;
   Interpreter();
-  Expression parseExpression(TokenIteratorType& token, TokenIteratorType end);
+  // parse one expression into arena. With a table, equal subtrees share
+  // the nodes interned there
+  Expression parseExpression(Lexer& lexer, AstArena& arena, HashConsTable* table = nullptr);
+  // resolve expr against the environment and evaluate it
   Expression evaluateExpression(const Expression& expr);
   void resetEnvironment();
-  bool isSymbolStringDefined(std::string variable);
+  bool isSymbolStringDefined(const std::string & variable);
+
+  // ASTs of recent inputs, reused when the same text is parsed again,
+  // once limits are set to enable it
+  ParseCache & parseCache() noexcept { return cache; }
+
+  // threads used to parse large inputs, 0 picks one per core and 1
+  // always parses on the calling thread
+  void setParseThreads(unsigned threads) noexcept { parseThreads = threads; }
+
+  // parse structurally identical subexpressions into one shared node,
+  // for generated programs that repeat the same forms many times
+  void setHashConsing(bool on) noexcept
+  {
+    // ASTs cached or kept for reuse in the other mode have the other
+    // shape
+    if (on != hashConsing)
+    {
+      cache.clear();
+      clearForms();
+    }
+    hashConsing = on;
+  }
+
+  // How eval runs a program: by walking its AST, or by compiling it to
+  // bytecode for a stack VM. Building with SLISP_BYTECODE_DEFAULT
+  // defined makes the VM the default
+  enum class Evaluator { Tree, Bytecode };
+#ifdef SLISP_BYTECODE_DEFAULT
+  static constexpr Evaluator DEFAULT_EVALUATOR = Evaluator::Bytecode;
+#else
+  static constexpr Evaluator DEFAULT_EVALUATOR = Evaluator::Tree;
+#endif
+  void setEvaluator(Evaluator use) noexcept { evaluator = use; }
+
+  // fold constants in programs before they run. With report, the nodes
+  // folded in the current program are listed in foldReport, until
+  // another program is parsed or loaded or the environment is reset
+  void setFolding(bool on, bool report = false) noexcept
+  {
+    folding = on;
+    foldReporting = report;
+  }
+  std::size_t foldCount() const noexcept { return foldedCount; }
+  const std::vector<FoldedNode> & foldReport() const noexcept { return folded; }
+
+  // keep the values of recent calls to costly builtins, such as sin, in
+  // a cache of about entries values, or keep none if entries is 0
+  void setMemoization(std::size_t entries)
+  {
+    memoEntries = entries;
+    env.setMemoCapacity(entries);
+  }
+  MemoStats memoStats() const noexcept { return env.memoStats(); }
+
+  // inputs at least this long are parsed one top level form at a time,
+  // and forms whose text did not change since the last such parse are
+  // reused instead of parsed again
+  static const std::size_t FORM_PARSE_MIN = 64 * 1024;
+
+  // when at least this much text has to be parsed, the forms are parsed
+  // in parallel
+  static const std::size_t PARALLEL_PARSE_MIN = 1024 * 1024;
 
 protected:
+  Expression evaluateNode(const ResolvedProgram& program, const ResolvedNode& root);
+  void clearResolved() noexcept;
+  void clearForms() noexcept;
+
+  bool parseSource(std::string_view source, bool cacheable) noexcept;
+
+  bool parseForms(std::string_view source, const std::shared_ptr<AstArena> & arena, Expression & program);
+
+  // A span of source, from one top level list to the next, and where
+  // its forms went in the last program parsed form by form. The hash of
+  // its text rules spans out quickly, and its place in formSource is
+  // where the text is compared
+  struct FormSpan
+  {
+    TextHash hash;
+    std::size_t offset;
+    std::size_t length;
+    std::size_t first;
+    std::size_t count;
+    std::size_t bytes;
+  };
+
   Environment env;
+  std::shared_ptr<AstArena> astArena;
   Expression ast;
+  // ast resolved against env, on the first eval after it was parsed or
+  // env was reset
+  ResolvedProgram resolved;
+  ParseCache cache;
+  unsigned parseThreads = 0;
+  bool hashConsing = false;
+  bool folding = false;
+  bool foldReporting = false;
+  std::size_t foldedCount = 0;
+  std::vector<FoldedNode> folded;
+  std::size_t memoEntries = 0;
+  Evaluator evaluator = DEFAULT_EVALUATOR;
+
+  // the source, spans and forms of the last program parsed form by
+  // form, and the arena their nodes are in
+  std::string formSource;
+  std::vector<FormSpan> formSpans;
+  std::vector<Expression> forms;
+  std::shared_ptr<AstArena> formArena;
   std::vector<Atom> graphics;
 };
 
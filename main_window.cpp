@@ -3,7 +3,6 @@
 #include <iostream>
 
 #include <QLayout>
-#include <fstream>
 #include <QDebug>
 
 #include "message_widget.hpp"
@@ -16,8 +15,15 @@ MainWindow::MainWindow(QWidget * parent): MainWindow("", parent)
   // TODO: your code here...
 }
 
-MainWindow::MainWindow(std::string filename, QWidget * parent): QWidget(parent)
+MainWindow::MainWindow(std::string filename, QWidget * parent):
+  MainWindow(filename, QtInterpreter::DEFAULT_EVALUATOR, parent)
 {
+}
+
+MainWindow::MainWindow(std::string filename, QtInterpreter::Evaluator evaluator, QWidget * parent): QWidget(parent)
+{
+    interp.setEvaluator(evaluator);
+
     // Create the widgets
     MessageWidget* messageWidget = new MessageWidget(this);
     CanvasWidget* canvasWidget = new CanvasWidget(this);
@@ -44,17 +50,9 @@ MainWindow::MainWindow(std::string filename, QWidget * parent): QWidget(parent)
     if (!filename.empty()) 
     {
         try {
-            std::ifstream ifs(filename);
-            if (ifs) 
-            {
-                std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-                QString qContent = QString::fromStdString(content);
-                interp.parseAndEvaluate(qContent);
-            }
-            else 
-            {
-                messageWidget->error("Error: Could not open file for reading.");
-            }
+            // Source and compiled programs are both read from the mapped
+            // file, and a file that does not open is reported as an error
+            interp.loadAndEvaluate(QString::fromStdString(filename));
         }
         catch (InterpreterSemanticError& e) 
         {
@@ -14,6 +14,7 @@ public:
 
   MainWindow(QWidget * parent = nullptr);
   MainWindow(std::string filename, QWidget * parent = nullptr);
+  MainWindow(std::string filename, QtInterpreter::Evaluator evaluator, QWidget * parent = nullptr);
 
 private:
 
@@ -0,0 +1,78 @@
+#include "mapped_file.hpp"
+
+// system includes
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string & filename, bool readUnmapped): opened(false), mapped(nullptr), size(0)
+{
+#ifdef MAPPED_FILE_MMAP
+	// Only regular files are mapped. Pipes are left to the fallback, so
+	// they are opened once
+	struct stat info;
+	int fd = -1;
+	if (::stat(filename.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+	{
+		fd = ::open(filename.c_str(), O_RDONLY);
+	}
+	if (fd >= 0)
+	{
+		if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+		{
+			void * pages = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (pages != MAP_FAILED)
+			{
+				// The parser reads the pages front to back
+				::madvise(pages, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+				mapped = pages;
+				size = static_cast<std::size_t>(info.st_size);
+				opened = true;
+			}
+		}
+		::close(fd);
+		if (opened)
+		{
+			return;
+		}
+	}
+#endif
+
+	// Fall back to reading the file into a buffer
+	if (!readUnmapped)
+	{
+		return;
+	}
+	std::ifstream ifs(filename, std::ios::binary);
+	if (ifs)
+	{
+		buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+		opened = true;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef MAPPED_FILE_MMAP
+	if (mapped != nullptr)
+	{
+		::munmap(mapped, size);
+	}
+#endif
+}
+
+std::string_view MappedFile::data() const noexcept
+{
+	if (mapped != nullptr)
+	{
+		return std::string_view(static_cast<const char *>(mapped), size);
+	}
+	return buffer;
+}
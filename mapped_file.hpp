@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+// system includes
+#include <string>
+#include <string_view>
+
+// A MappedFile gives read-only access to the contents of a file. On
+// POSIX systems the file is memory-mapped, so nothing is copied until
+// the pages are touched. Elsewhere, or if mapping fails, the file is
+// read into a buffer instead, unless readUnmapped is false, which
+// leaves files that cannot be mapped, such as pipes, unopened and
+// unread for the caller to stream
+class MappedFile
+{
+public:
+  MappedFile() noexcept: opened(false), mapped(nullptr), size(0){};
+  explicit MappedFile(const std::string & filename, bool readUnmapped = true);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+  ~MappedFile();
+
+  // false if the file could not be opened
+  bool isOpen() const noexcept { return opened; }
+
+  // the contents of the file, valid while this object is
+  std::string_view data() const noexcept;
+
+private:
+  bool opened;
+  void * mapped;
+  std::size_t size;
+  std::string buffer;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "memo.hpp"
+
+// system includes
+#include <algorithm>
+#include <cstring>
+
+MemoCache::MemoCache(std::size_t capacity): shift(64)
+{
+  std::size_t size = 1;
+  while (size < capacity)
+  {
+    size *= 2;
+    --shift;
+  }
+  entries.resize(size);
+}
+
+std::uint32_t MemoCache::memoize(Procedure proc)
+{
+  const auto known = std::find(procedures.begin(), procedures.end(), proc);
+  if (known != procedures.end())
+  {
+    return static_cast<std::uint32_t>(known - procedures.begin());
+  }
+  procedures.push_back(proc);
+  return static_cast<std::uint32_t>(procedures.size() - 1);
+}
+
+void MemoCache::apply(std::uint32_t index, Procedure proc, const Atom * args, std::size_t count, Atom & result)
+{
+  if (count > MAX_ARGUMENTS)
+  {
+    proc(Arguments(args, count), result);
+    return;
+  }
+
+  // The key is the bits of the Numbers, so -0 and 0 are different calls
+  // and a NaN finds the value of the same NaN
+  std::uint64_t bits[MAX_ARGUMENTS] = {};
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (args[i].type != NumberType)
+    {
+      proc(Arguments(args, count), result);
+      return;
+    }
+    std::memcpy(&bits[i], &args[i].value.num_value, sizeof(bits[i]));
+  }
+
+  // A procedure is known by the order it was memoized in, not by its
+  // address, so where a call goes is the same from run to run. Fibonacci
+  // hashing spreads the keys over the top bits
+  std::uint64_t hash = (static_cast<std::uint64_t>(index) << 8) ^ count;
+  for (std::size_t i = 0; i < MAX_ARGUMENTS; ++i)
+  {
+    hash = (hash ^ bits[i]) * 0x9e3779b97f4a7c15ull;
+  }
+  Entry & entry = entries[shift == 64 ? 0 : hash >> shift];
+
+  if (entry.proc == proc && entry.count == count && std::equal(bits, bits + MAX_ARGUMENTS, entry.bits))
+  {
+    ++counts.hits;
+    result = entry.value;
+    return;
+  }
+  ++counts.misses;
+
+  // A call that fails leaves the entry as it was
+  proc(Arguments(args, count), result);
+  entry.proc = proc;
+  entry.count = count;
+  std::copy(bits, bits + MAX_ARGUMENTS, entry.bits);
+  entry.value = result;
+}
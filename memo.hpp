@@ -0,0 +1,70 @@
+#ifndef MEMO_HPP
+#define MEMO_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+
+// Lookups in a MemoCache, those that found a value and those that did not
+struct MemoStats
+{
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+
+  // hits per lookup, 0 before the first
+  double hitRate() const noexcept
+  {
+    return hits + misses == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+  }
+};
+
+// A MemoCache keeps the values of recent calls to pure procedures, so a
+// call repeated with the same arguments is answered without being made.
+// Calls are keyed by the procedure and the bits of their arguments, which
+// must be at most MAX_ARGUMENTS Numbers, so only a call with exactly the
+// same arguments finds a value. The cache has a fixed number of entries
+// and each key has one place in it: a new value there replaces the old
+class MemoCache
+{
+public:
+  static const std::size_t MAX_ARGUMENTS = 2;
+
+  // a cache of capacity entries, rounded up to a power of two
+  explicit MemoCache(std::size_t capacity);
+
+  // memoize calls to proc, which must be pure, and give the index that
+  // stands for it in apply
+  std::uint32_t memoize(Procedure proc);
+
+  // apply proc, memoized as index, to the count args, or give the value
+  // of the same call made before. Calls that can not be keyed are always
+  // made
+  void apply(std::uint32_t index, Procedure proc, const Atom * args, std::size_t count, Atom & result);
+
+  std::size_t capacity() const noexcept { return entries.size(); }
+  const MemoStats & stats() const noexcept { return counts; }
+
+private:
+  struct Entry
+  {
+    Procedure proc = nullptr;
+    std::size_t count = 0;
+    std::uint64_t bits[MAX_ARGUMENTS] = {};
+    Atom value;
+  };
+
+  std::vector<Entry> entries;
+  std::vector<Procedure> procedures;
+  MemoStats counts;
+  // the top bits of a hash pick the entry
+  unsigned shift;
+};
+
+// entries of the cache set up by Environment::setMemoCapacity by default
+const std::size_t DEFAULT_MEMO_ENTRIES = 4096;
+
+#endif
@@ -0,0 +1,306 @@
+#include "optimizer.hpp"
+
+// system includes
+#include <cstdint>
+
+// module includes
+#include "interpreter_semantic_error.hpp"
+#include "small_vector.hpp"
+
+namespace
+{
+  // set flags[i], growing flags to fit
+  void mark(std::vector<bool> & flags, std::size_t i)
+  {
+    if (i >= flags.size())
+    {
+      flags.resize(i + 1, false);
+    }
+    flags[i] = true;
+  }
+
+  class Folder
+  {
+  public:
+    Folder(Environment & env, ResolvedProgram & program, bool sharedTails, std::vector<FoldedNode> * report)
+      : env(env), program(program), nodes(program.nodes), sharedTails(sharedTails), report(report)
+    {
+      // Defines can bind names to procedures anew, so calls to the
+      // names the program defines are left as they are
+      for (const ResolvedNode & node : nodes)
+      {
+        if (node.form == Form::Define || node.form == Form::DefineReserved)
+        {
+          mark(rebound, node.operand);
+        }
+      }
+      if (sharedTails)
+      {
+        visited.resize(nodes.size(), false);
+      }
+    }
+
+    // fold the node at index, resolved from exp, and the nodes below it,
+    // in the order they are evaluated. Nodes whose children are being
+    // folded are kept on an explicit stack, so programs of any depth are
+    // folded without running out of call stack
+    void fold(std::uint32_t index, const Expression & exp)
+    {
+      open.clear();
+      enter(index, exp);
+      while (!open.empty())
+      {
+        // Entering a child can move the stack, so the step is taken first.
+        // Folding only changes nodes in place, so node stays valid
+        OpenNode & top = open.back();
+        ResolvedNode & node = nodes[top.index];
+        const Expression & source = *top.exp;
+        const std::uint32_t step = top.step++;
+
+        switch (node.form)
+        {
+        case Form::If:
+          if (step == 0)
+          {
+            enter(node.children.first, source.tail[0]);
+          }
+          else if (step == 1)
+          {
+            const ResolvedNode & condition = nodes[node.children.first];
+            if (condition.form == Form::Constant && condition.constant->head.type == BooleanType)
+            {
+              // The branch not taken is dropped, and the one taken is folded
+              // as if it stood in place of the if
+              const std::uint32_t taken = condition.constant->head.value.bool_value ? 1 : 2;
+              enter(node.children.first + taken, source.tail[taken]);
+            }
+            else
+            {
+              ++branches;
+              top.step = BRANCHES;
+              enter(node.children.first + 1, source.tail[1]);
+            }
+          }
+          else if (step == 2)
+          {
+            const ResolvedNode & condition = nodes[node.children.first];
+            const std::uint32_t taken = condition.constant->head.value.bool_value ? 1 : 2;
+            record(FoldKind::Branch, source, *condition.constant);
+            node = nodes[node.children.first + taken];
+            open.pop_back();
+          }
+          else if (step == BRANCHES)
+          {
+            enter(node.children.first + 2, source.tail[2]);
+          }
+          else
+          {
+            --branches;
+            open.pop_back();
+          }
+          break;
+        case Form::Begin:
+          if (step < node.children.count)
+          {
+            enter(node.children.first + step, source.tail[step]);
+          }
+          else
+          {
+            open.pop_back();
+          }
+          break;
+        case Form::Define:
+          if (step == 0)
+          {
+            enter(node.children.first + 1, source.tail[1]);
+          }
+          else
+          {
+            // Only a define that always runs binds the name for the rest of
+            // the program. It fails if the name is bound already, and then
+            // the rest never runs
+            const ResolvedNode & value = nodes[node.children.first + 1];
+            if (!sharedTails && branches == 0 && value.form == Form::Constant && valueOf(node.operand) == nullptr)
+            {
+              if (node.operand >= known.size())
+              {
+                known.resize(node.operand + 1, nullptr);
+              }
+              known[node.operand] = value.constant;
+            }
+            open.pop_back();
+          }
+          break;
+        case Form::Call:
+          if (step < node.children.count)
+          {
+            enter(node.children.first + step, source.tail[step]);
+          }
+          else
+          {
+            open.pop_back();
+            foldCall(node, source);
+          }
+          break;
+        default:
+          open.pop_back();
+          break;
+        }
+      }
+    }
+
+    std::size_t folded = 0;
+
+  private:
+    // the value slot is known to have wherever it is used, or nullptr.
+    // Values bound in env are copied once, into the program
+    const Expression * valueOf(Environment::Slot slot)
+    {
+      if (slot < known.size() && known[slot] != nullptr)
+      {
+        return known[slot];
+      }
+      const Expression * bound = env.lookup(slot);
+      if (bound == nullptr)
+      {
+        return nullptr;
+      }
+      if (slot >= known.size())
+      {
+        known.resize(slot + 1, nullptr);
+      }
+      program.values.push_back(*bound);
+      known[slot] = &program.values.back();
+      return known[slot];
+    }
+
+    // A node whose children are being folded, the expression it was
+    // resolved from, and the step it is at. An if whose condition is not
+    // known folds both branches from step BRANCHES on
+    struct OpenNode
+    {
+      std::uint32_t index;
+      const Expression * exp;
+      std::uint32_t step;
+    };
+    static constexpr std::uint32_t BRANCHES = 3;
+
+    // fold a node without children, or open the node
+    void enter(std::uint32_t index, const Expression & exp)
+    {
+      if (sharedTails)
+      {
+        if (visited[index])
+        {
+          return;
+        }
+        visited[index] = true;
+      }
+
+      ResolvedNode & node = nodes[index];
+      switch (node.form)
+      {
+      case Form::Variable:
+      {
+        const Expression * value = valueOf(node.operand);
+        if (value != nullptr)
+        {
+          setConstant(node, value);
+          record(FoldKind::Global, exp, *value);
+        }
+        break;
+      }
+      case Form::If:
+      case Form::Begin:
+      case Form::Define:
+      case Form::Call:
+        open.push_back({ index, &exp, 0 });
+        break;
+      case Form::Constant:
+      case Form::DefineReserved:
+      case Form::Invalid:
+        break;
+      }
+    }
+
+    // make a call to a pure procedure whose arguments are all known
+    void foldCall(ResolvedNode & node, const Expression & exp)
+    {
+      if (!env.isPure(node.operand) || (node.operand < rebound.size() && rebound[node.operand]))
+      {
+        return;
+      }
+
+      // The procedure converts its arguments in place, so it is given
+      // copies
+      SmallVector<Atom, 8> args;
+      args.reserve(node.children.count);
+      for (std::uint32_t i = 0; i < node.children.count; ++i)
+      {
+        const ResolvedNode & arg = nodes[node.children.first + i];
+        if (arg.form != Form::Constant)
+        {
+          return;
+        }
+        args.push_back(arg.constant->head);
+      }
+
+      Expression value;
+      try
+      {
+        env.apply(env.callee(node.operand), args.data(), args.size(), value.head);
+      }
+      catch (const InterpreterSemanticError &)
+      {
+        return;
+      }
+      program.values.push_back(std::move(value));
+      setConstant(node, &program.values.back());
+      record(FoldKind::Call, exp, program.values.back());
+    }
+
+    static void setConstant(ResolvedNode & node, const Expression * value) noexcept
+    {
+      node.form = Form::Constant;
+      node.operand = 0;
+      node.constant = value;
+    }
+
+    void record(FoldKind kind, const Expression & source, const Expression & value)
+    {
+      ++folded;
+      if (report != nullptr)
+      {
+        report->push_back({ kind, &source, value });
+      }
+    }
+
+    Environment & env;
+    ResolvedProgram & program;
+    std::vector<ResolvedNode> & nodes;
+    const bool sharedTails;
+    std::vector<FoldedNode> * report;
+
+    // the slots the program defines, the values known for slots by
+    // their slot, and with sharedTails the nodes folded already
+    std::vector<bool> rebound;
+    std::vector<const Expression *> known;
+    std::vector<bool> visited;
+    // the branches of ifs being folded, inside which defines may not run
+    unsigned branches = 0;
+    std::vector<OpenNode> open;
+  };
+}
+
+std::size_t foldProgram(const Expression & ast, Environment & env, ResolvedProgram & program,
+  bool sharedTails, std::vector<FoldedNode> * report)
+{
+  if (program.empty())
+  {
+    return 0;
+  }
+
+  Folder folder(env, program, sharedTails, report);
+  folder.fold(0, ast);
+  return folder.folded;
+}
@@ -0,0 +1,45 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+// system includes
+#include <cstddef>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+#include "environment.hpp"
+#include "resolver.hpp"
+
+// How a node was folded
+enum class FoldKind
+{
+  Call,   // a call to a pure procedure, made before the program runs
+  Global, // a name bound to a value that can not change
+  Branch  // an if whose condition is known, replaced by the branch taken
+};
+
+// A folded node, the expression it was resolved from, and its value, or
+// for a Branch the value of the condition
+struct FoldedNode
+{
+  FoldKind kind;
+  const Expression * source;
+  Expression value;
+};
+
+// Fold program, resolved from ast against env, before it runs. Names
+// bound to expressions can not be bound again, so they are replaced by
+// their values: those bound in env, and those the program itself binds
+// unconditionally before their use. Calls to pure procedures the program
+// does not rebind are made when all their arguments are known, and an if
+// whose condition is known becomes the branch it takes. Calls that fail
+// are left to fail when the program runs. sharedTails must be set for
+// programs resolved with shareTails, whose nodes may stand for several
+// places in the program, and then only names bound in env are replaced.
+// The folded nodes are added to report, if given, and their number is
+// returned. The program is walked without recursion, so it is folded
+// whatever its depth
+std::size_t foldProgram(const Expression & ast, Environment & env, ResolvedProgram & program,
+  bool sharedTails = false, std::vector<FoldedNode> * report = nullptr);
+
+#endif
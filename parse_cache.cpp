@@ -0,0 +1,87 @@
+#include "parse_cache.hpp"
+
+ParseCache::ParseCache(std::size_t maxEntries, std::size_t maxBytes)
+	: maxEntries(maxEntries), maxBytes(maxBytes), bytes(0), hitCount(0), missCount(0)
+{
+}
+
+ParseCache::Key ParseCache::keyOf(std::string_view source) noexcept
+{
+	return Key{ TextHash(source), source.size() };
+}
+
+std::size_t ParseCache::bytesOf(const Cached & cached) noexcept
+{
+	return (cached.entry.arena ? cached.entry.arena->bytesUsed() : 0) + cached.text.size();
+}
+
+bool ParseCache::find(const Key & key, std::string_view source, Entry & entry)
+{
+	if (maxEntries == 0)
+	{
+		return false;
+	}
+
+	// An entry whose hash and length match but whose text does not is a
+	// collision, and is replaced when source is inserted
+	auto it = index.find(key);
+	if (it == index.end() || it->second->text != source)
+	{
+		++missCount;
+		return false;
+	}
+
+	// Move the entry to the front of the recently used list
+	entries.splice(entries.begin(), entries, it->second);
+	entry = it->second->entry;
+	++hitCount;
+	return true;
+}
+
+void ParseCache::insert(const Key & key, std::string_view source, const Entry & entry)
+{
+	const std::size_t entryBytes = (entry.arena ? entry.arena->bytesUsed() : 0) + source.size();
+	if (maxEntries == 0 || entryBytes > maxBytes)
+	{
+		return;
+	}
+
+	auto it = index.find(key);
+	if (it != index.end())
+	{
+		bytes -= bytesOf(*it->second);
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	entries.push_front({ key, std::string(source), entry });
+	index[key] = entries.begin();
+	bytes += entryBytes;
+	evict();
+}
+
+void ParseCache::setLimits(std::size_t maxEntries, std::size_t maxBytes)
+{
+	this->maxEntries = maxEntries;
+	this->maxBytes = maxBytes;
+	evict();
+}
+
+void ParseCache::clear() noexcept
+{
+	entries.clear();
+	index.clear();
+	bytes = 0;
+}
+
+// Drop least recently used entries until the cache is within its limits
+void ParseCache::evict()
+{
+	while (!entries.empty() && (entries.size() > maxEntries || bytes > maxBytes))
+	{
+		const Cached & last = entries.back();
+		bytes -= bytesOf(last);
+		index.erase(last.key);
+		entries.pop_back();
+	}
+}
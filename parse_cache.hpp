@@ -0,0 +1,101 @@
+#ifndef PARSE_CACHE_HPP
+#define PARSE_CACHE_HPP
+
+// system includes
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// module includes
+#include "expression.hpp"
+#include "ast_arena.hpp"
+#include "text_hash.hpp"
+
+// A ParseCache remembers the ASTs of recently parsed inputs, so parsing
+// the same text again returns the existing tree. Entries are found by the
+// 128-bit TextHash and the length of the input text. TextHash is fast but
+// not collision resistant, so each entry keeps a copy of its text and a
+// hit is only taken once the text matches too: inputs whose hashes
+// collide never share a tree. That costs a copy of each cached input and
+// a compare per hit, both linear in the text, as the parse they save is.
+// It is bounded both in entries and in bytes, counting the arenas and the
+// kept texts, and evicts the least recently used entry first. A cache
+// starts disabled, as a program parsed once gains nothing from it
+class ParseCache
+{
+public:
+  // what an input is known by
+  struct Key
+  {
+    TextHash hash;
+    std::size_t length;
+    bool operator==(const Key & key) const noexcept { return hash == key.hash && length == key.length; }
+  };
+
+  static Key keyOf(std::string_view source) noexcept;
+
+  // A cached program: its root and the arena that holds its nodes
+  struct Entry
+  {
+    std::shared_ptr<AstArena> arena;
+    Expression ast;
+  };
+
+  ParseCache(std::size_t maxEntries = 0, std::size_t maxBytes = 0);
+
+  // look up the AST of source, whose key is key, counting a hit or a
+  // miss
+  bool find(const Key & key, std::string_view source, Entry & entry);
+
+  // remember the AST of source, whose key is key, evicting old entries
+  // to stay in bounds
+  void insert(const Key & key, std::string_view source, const Entry & entry);
+
+  // change the bounds, a limit of 0 entries disables the cache
+  void setLimits(std::size_t maxEntries, std::size_t maxBytes);
+  bool enabled() const noexcept { return maxEntries != 0; }
+
+  void clear() noexcept;
+
+  std::size_t hits() const noexcept { return hitCount; }
+  std::size_t misses() const noexcept { return missCount; }
+  std::size_t size() const noexcept { return entries.size(); }
+
+private:
+  struct KeyHash
+  {
+    std::size_t operator()(const Key & key) const noexcept { return key.hash.value(); }
+  };
+
+  // an entry, and the key and text of the input it was parsed from
+  struct Cached
+  {
+    Key key;
+    std::string text;
+    Entry entry;
+  };
+
+  typedef std::list<Cached> EntryList;
+
+  static std::size_t bytesOf(const Cached & cached) noexcept;
+  void evict();
+
+  std::size_t maxEntries;
+  std::size_t maxBytes;
+  std::size_t bytes;
+  std::size_t hitCount;
+  std::size_t missCount;
+
+  // most recently used first
+  EntryList entries;
+  std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+};
+
+// the bounds of a cache enabled with the defaults
+const std::size_t DEFAULT_PARSE_CACHE_ENTRIES = 32;
+const std::size_t DEFAULT_PARSE_CACHE_BYTES = 128 * 1024 * 1024;
+
+#endif
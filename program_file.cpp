@@ -0,0 +1,390 @@
+#include "program_file.hpp"
+
+// system includes
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	const char MAGIC[4] = { 'S', 'L', 'C', '\0' };
+	const std::uint16_t BYTE_ORDER_MARK = 0x0102;
+	const std::size_t HEADER_SIZE = 16;
+
+	// Set in the type byte of a number stored as a zigzag varint
+	const std::uint8_t SMALL_INTEGER = 0x80;
+
+	// Append the bytes of a trivially copyable value
+	template<typename T>
+	void put(std::string & out, const T & value)
+	{
+		out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+	}
+
+	void putVarint(std::string & out, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out += static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		out += static_cast<char>(value);
+	}
+
+	// Bounds-checked reads from a program image
+	class Reader
+	{
+	public:
+		explicit Reader(std::string_view data): data(data), pos(0){};
+
+		template<typename T>
+		bool get(T & value) noexcept
+		{
+			if (data.size() - pos < sizeof(T))
+			{
+				return false;
+			}
+			std::memcpy(&value, data.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+
+		bool getVarint(std::uint64_t & value) noexcept
+		{
+			value = 0;
+			for (unsigned shift = 0; shift < 64 && pos < data.size(); shift += 7)
+			{
+				const std::uint8_t byte = static_cast<std::uint8_t>(data[pos++]);
+				value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool getBytes(std::size_t count, std::string_view & bytes) noexcept
+		{
+			if (data.size() - pos < count)
+			{
+				return false;
+			}
+			bytes = data.substr(pos, count);
+			pos += count;
+			return true;
+		}
+
+		bool atEnd() const noexcept { return pos == data.size(); }
+		std::size_t left() const noexcept { return data.size() - pos; }
+
+	private:
+		std::string_view data;
+		std::size_t pos;
+	};
+
+	// Append one node, without its tail, to out
+	void putNode(std::string & out, const Expression & exp, std::unordered_map<Symbol, std::uint32_t> & symbolIndex, std::vector<Symbol> & symbols)
+	{
+		const Atom & atom = exp.head;
+
+		// Most numbers in scripts are small integers, which fit in a few
+		// bytes instead of a double. Negative zero keeps its double form
+		const double num = atom.type == NumberType ? atom.value.num_value : 0;
+		if (atom.type == NumberType && num >= -2147483648.0 && num <= 2147483647.0 &&
+			num == static_cast<double>(static_cast<std::int32_t>(num)) && !(num == 0 && std::signbit(num)))
+		{
+			const std::int64_t integer = static_cast<std::int32_t>(num);
+			put(out, static_cast<std::uint8_t>(NumberType | SMALL_INTEGER));
+			putVarint(out, static_cast<std::uint64_t>((integer << 1) ^ (integer >> 63)));
+			putVarint(out, exp.tail.size());
+			return;
+		}
+
+		put(out, static_cast<std::uint8_t>(atom.type));
+
+		switch (atom.type)
+		{
+		case BooleanType:
+			put(out, static_cast<std::uint8_t>(atom.value.bool_value));
+			break;
+		case NumberType:
+			put(out, num);
+			break;
+		case SymbolType:
+		{
+			auto inserted = symbolIndex.emplace(atom.value.sym_value, static_cast<std::uint32_t>(symbols.size()));
+			if (inserted.second)
+			{
+				symbols.push_back(atom.value.sym_value);
+			}
+			putVarint(out, inserted.first->second);
+			break;
+		}
+		case PointType:
+			put(out, atom.value.point_value.x);
+			put(out, atom.value.point_value.y);
+			break;
+		case LineType:
+			put(out, atom.value.line_value.first.x);
+			put(out, atom.value.line_value.first.y);
+			put(out, atom.value.line_value.second.x);
+			put(out, atom.value.line_value.second.y);
+			break;
+		case ArcType:
+			put(out, atom.value.arc_value.center.x);
+			put(out, atom.value.arc_value.center.y);
+			put(out, atom.value.arc_value.start.x);
+			put(out, atom.value.arc_value.start.y);
+			put(out, atom.value.arc_value.span);
+			break;
+		case ArrayType:
+			putVarint(out, atom.value.array_value.size);
+			out.append(reinterpret_cast<const char *>(atom.value.array_value.data), atom.value.array_value.size * sizeof(Number));
+			break;
+		default:
+			break;
+		}
+
+		putVarint(out, exp.tail.size());
+	}
+
+	// Read one node into exp and return the size of its tail
+	bool getNode(Reader & in, const std::vector<Symbol> & symbols, AstArena & arena, Expression & exp, std::uint64_t & tailSize)
+	{
+		std::uint8_t type = 0;
+		if (!in.get(type))
+		{
+			return false;
+		}
+
+		Atom & atom = exp.head;
+		if (type == (NumberType | SMALL_INTEGER))
+		{
+			std::uint64_t zigzag = 0;
+			if (!in.getVarint(zigzag))
+			{
+				return false;
+			}
+			atom.type = NumberType;
+			atom.value.num_value = static_cast<double>(static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1));
+			return in.getVarint(tailSize);
+		}
+		if (type > ArrayType)
+		{
+			return false;
+		}
+		atom.type = static_cast<Type>(type);
+
+		bool ok = true;
+		switch (atom.type)
+		{
+		case BooleanType:
+		{
+			std::uint8_t tf = 0;
+			ok = in.get(tf);
+			atom.value.bool_value = tf != 0;
+			break;
+		}
+		case NumberType:
+			ok = in.get(atom.value.num_value);
+			break;
+		case SymbolType:
+		{
+			std::uint64_t index = 0;
+			ok = in.getVarint(index) && index < symbols.size();
+			if (ok)
+			{
+				atom.value.sym_value = symbols[index];
+			}
+			break;
+		}
+		case PointType:
+			ok = in.get(atom.value.point_value.x) && in.get(atom.value.point_value.y);
+			break;
+		case LineType:
+			ok = in.get(atom.value.line_value.first.x) && in.get(atom.value.line_value.first.y) &&
+				in.get(atom.value.line_value.second.x) && in.get(atom.value.line_value.second.y);
+			break;
+		case ArcType:
+			ok = in.get(atom.value.arc_value.center.x) && in.get(atom.value.arc_value.center.y) &&
+				in.get(atom.value.arc_value.start.x) && in.get(atom.value.arc_value.start.y) &&
+				in.get(atom.value.arc_value.span);
+			break;
+		case ArrayType:
+		{
+			// The doubles are copied out, the image need not be aligned
+			std::uint64_t size = 0;
+			std::string_view bytes;
+			ok = in.getVarint(size) && size <= SIZE_MAX / sizeof(Number) && in.getBytes(size * sizeof(Number), bytes);
+			if (ok)
+			{
+				Number * data = arena.allocateArray<Number>(size);
+				if (size > 0)
+				{
+					std::memcpy(data, bytes.data(), bytes.size());
+				}
+				atom.value.array_value.data = data;
+				atom.value.array_value.size = size;
+				atom.value.array_value.hash = hashNumbers(data, size);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+
+		return ok && in.getVarint(tailSize);
+	}
+}
+
+bool isProgramFile(std::string_view data) noexcept
+{
+	return data.size() >= sizeof(MAGIC) && std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void writeProgram(std::ostream & out, const Expression & ast)
+{
+	std::unordered_map<Symbol, std::uint32_t> symbolIndex;
+	std::vector<Symbol> symbols;
+	std::string nodes;
+	std::uint32_t nodeCount = 0;
+
+	// Walk the tree in preorder with an explicit stack, so deep programs
+	// do not exhaust the call stack
+	std::vector<const Expression *> pending = { &ast };
+	while (!pending.empty())
+	{
+		const Expression * exp = pending.back();
+		pending.pop_back();
+
+		putNode(nodes, *exp, symbolIndex, symbols);
+		++nodeCount;
+
+		for (std::size_t i = exp->tail.size(); i > 0; --i)
+		{
+			pending.push_back(&exp->tail[i - 1]);
+		}
+	}
+
+	std::string header(MAGIC, sizeof(MAGIC));
+	put(header, PROGRAM_FILE_VERSION);
+	put(header, BYTE_ORDER_MARK);
+	put(header, static_cast<std::uint32_t>(symbols.size()));
+	put(header, nodeCount);
+	for (const Symbol & sym : symbols)
+	{
+		putVarint(header, sym.str().size());
+		header += sym.str();
+	}
+
+	out.write(header.data(), static_cast<std::streamsize>(header.size()));
+	out.write(nodes.data(), static_cast<std::streamsize>(nodes.size()));
+}
+
+bool readProgram(std::string_view data, AstArena & arena, Expression & ast) noexcept
+{
+	if (!isProgramFile(data) || data.size() < HEADER_SIZE)
+	{
+		return false;
+	}
+
+	Reader in(data.substr(sizeof(MAGIC)));
+	std::uint16_t version = 0;
+	std::uint16_t byteOrder = 0;
+	std::uint32_t symbolCount = 0;
+	std::uint32_t nodeCount = 0;
+	if (!in.get(version) || version == 0 || version > PROGRAM_FILE_VERSION ||
+		!in.get(byteOrder) || byteOrder != BYTE_ORDER_MARK ||
+		!in.get(symbolCount) || !in.get(nodeCount) || nodeCount == 0)
+	{
+		return false;
+	}
+
+	try
+	{
+		// Intern the symbols once, nodes refer to them by index
+		std::vector<Symbol> symbols;
+		for (std::uint32_t i = 0; i < symbolCount; ++i)
+		{
+			std::uint64_t length = 0;
+			std::string_view name;
+			if (!in.getVarint(length) || !in.getBytes(length, name))
+			{
+				return false;
+			}
+			symbols.emplace_back(name);
+		}
+
+		// Every node takes at least one byte, so counts beyond the bytes
+		// left are refused before anything is allocated for them
+		if (nodeCount > in.left())
+		{
+			return false;
+		}
+
+		// Tails are allocated as soon as their size is known and filled in
+		// place as their nodes are read, so nothing is moved afterwards.
+		// The owner of a tail takes it once it is full, so the hash of the
+		// tail is taken over nodes that are complete
+		struct OpenTail
+		{
+			Expression * owner;
+			Expression * items;
+			std::uint32_t size;
+			std::uint32_t next;
+		};
+		std::vector<OpenTail> openTails;
+		std::uint32_t remaining = nodeCount;
+
+		Expression root;
+		Expression * target = &root;
+		while (true)
+		{
+			std::uint64_t tailSize = 0;
+			if (remaining == 0 || !getNode(in, symbols, arena, *target, tailSize) ||
+				tailSize >= remaining || tailSize > in.left())
+			{
+				return false;
+			}
+			--remaining;
+
+			if (tailSize > 0)
+			{
+				const std::uint32_t size = static_cast<std::uint32_t>(tailSize);
+				Expression * items = arena.allocateArray<Expression>(size);
+				for (std::uint32_t i = 0; i < size; ++i)
+				{
+					new (items + i) Expression();
+				}
+				openTails.push_back({ target, items, size, 0 });
+			}
+
+			while (!openTails.empty() && openTails.back().next == openTails.back().size)
+			{
+				const OpenTail & full = openTails.back();
+				full.owner->tail = ExpressionList::view(full.items, full.size);
+				openTails.pop_back();
+			}
+			if (openTails.empty())
+			{
+				break;
+			}
+			target = &openTails.back().items[openTails.back().next++];
+		}
+
+		if (remaining != 0 || !in.atEnd())
+		{
+			return false;
+		}
+		ast = root;
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef PROGRAM_FILE_HPP
+#define PROGRAM_FILE_HPP
+
+// system includes
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+// module includes
+#include "expression.hpp"
+#include "ast_arena.hpp"
+
+// A compiled program (.slc) holds a parsed AST in a compact binary form,
+// so it can be loaded without tokenizing or parsing its source again.
+//
+// Layout, with fixed-size integers and doubles in host byte order and
+// counts written as LEB128 varints:
+//   header   "SLC" 0, uint16 version, uint16 byte order mark 0x0102,
+//            uint32 symbol count, uint32 node count
+//   symbols  per symbol: varint length followed by its characters
+//   nodes    in preorder, per node: uint8 type, its value, then the
+//            varint tail size. The value is a uint8 for a boolean, a
+//            varint index into the symbols, 1 to 5 doubles for numbers
+//            and geometry, a varint count and that many doubles for an
+//            array, or for integral numbers marked with the
+//            SMALL_INTEGER flag in the type, a zigzag varint
+// Version 2 added arrays, version 1 files are read as well
+const std::uint16_t PROGRAM_FILE_VERSION = 2;
+
+// true if data starts with the magic of a compiled program
+bool isProgramFile(std::string_view data) noexcept;
+
+// write the program rooted at ast in the compiled format
+void writeProgram(std::ostream & out, const Expression & ast);
+
+// read a compiled program, putting its tails in arena
+// returns false if data is not a valid program of this version
+bool readProgram(std::string_view data, AstArena & arena, Expression & ast) noexcept;
+
+#endif
@@ -18,25 +18,51 @@
 
 QtInterpreter::QtInterpreter(QObject * parent): QObject(parent)
 {
-  // TODO: your code here...
+  // The same script is often submitted again unchanged
+  parseCache().setLimits(DEFAULT_PARSE_CACHE_ENTRIES, DEFAULT_PARSE_CACHE_BYTES);
 }
 
 void QtInterpreter::parseAndEvaluate(QString entry) {
+    // Parsed straight from the text, so a resubmitted script only has its
+    // changed top level forms parsed again
+    const std::string source = entry.toStdString();
+    bool success = parse(std::string_view(source));
+    if (success) {
+        evaluateAndDraw();
+    }
+    else {
+        emit error("Failed to parse the expression.");
+    }
+}
+
+// Same as parseAndEvaluate for a script file, or a program compiled with
+// slisp --compile. The file is mapped and parsed in place, not copied
+void QtInterpreter::loadAndEvaluate(QString filename) {
+    // The file is opened once, and read straight from the mapped pages
+    MappedFile file(filename.toStdString());
+    if (!file.isOpen()) {
+        emit error("Error: Could not open file for reading.");
+        return;
+    }
+
+    bool success = parseFile(file);
+    if (success) {
+        evaluateAndDraw();
+    }
+    else {
+        emit error("Failed to parse the expression.");
+    }
+}
+
+void QtInterpreter::evaluateAndDraw() {
     try {
-        std::istringstream expressionStream(entry.toStdString());
-        bool success = parse(expressionStream);
-        if (success) {
-            // Instead of calling eval, we directly use evaluateExpression on the AST
-            Expression result = evaluateExpression(ast);
+        // eval runs the AST on the evaluator that was picked for it
+        Expression result = eval();
 
-            emit clearCanvasSignal();
+        emit clearCanvasSignal();
 
-            // Now we draw the result, which could be a single expression or a list
-            drawExpression(result);
-        }
-        else {
-            emit error("Failed to parse the expression.");
-        }
+        // Now we draw the result, which could be a single expression or a list
+        drawExpression(result);
     }
     catch (const InterpreterSemanticError& e) {
         emit error(QString::fromStdString(e.what()));
@@ -66,7 +92,7 @@ void QtInterpreter::drawExpression(const Expression& result) {
         break;
     }
     case SymbolType:
-        resultStr = result.head.value.sym_value;
+        resultStr = result.head.value.sym_value.str();
         break;
 
     case PointType:
@@ -89,6 +115,17 @@ void QtInterpreter::drawExpression(const Expression& result) {
         resultStr = "((" + std::to_string(x) + ", " + std::to_string(y) + "), (" + std::to_string(result.head.value.arc_value.start.x) + ", " + std::to_string(result.head.value.arc_value.start.y) + "), " + std::to_string(result.head.value.arc_value.span) + ")";
         break;
 
+    case ArrayType:
+    {
+        // The numbers of an array are x y pairs, each drawn as a point
+        const Array & array = result.head.value.array_value;
+        for (std::size_t i = 0; i + 1 < array.size; i += 2) {
+            emit drawGraphic(new QGraphicsEllipseItem(array.data[i], array.data[i + 1], 1, 1));
+        }
+        resultStr = "#[" + std::to_string(array.size) + " numbers]";
+        break;
+    }
+
     case ListType:
         // If the expression is a list, iterate and draw each sub-expression
         for (const auto& subExpr : result.tail) 
@@ -148,7 +185,7 @@ void QtInterpreter::drawExpression(const Expression& result) {
 //                break;
 //            }
 //            case SymbolType:
-//                resultStr = result.head.value.sym_value;
+//                resultStr = result.head.value.sym_value.str();
 //                break;
 //
 //            case PointType:
@@ -17,6 +17,10 @@ public:
 
   QtInterpreter(QObject * parent = nullptr);
 
+  using Interpreter::Evaluator;
+  using Interpreter::DEFAULT_EVALUATOR;
+  using Interpreter::setEvaluator;
+
 signals:
 
   void drawGraphic(QGraphicsItem * item);
@@ -30,7 +34,12 @@ signals:
 public slots:
 
   void parseAndEvaluate(QString entry);
+  void loadAndEvaluate(QString filename);
   void drawExpression(const Expression& expr);
+
+private:
+
+  void evaluateAndDraw();
 };
 
 #endif
@@ -0,0 +1,141 @@
+#include "resolver.hpp"
+
+// system includes
+#include <unordered_map>
+
+// module includes
+#include "special_forms.hpp"
+
+namespace
+{
+  const char * const RESOLVE_ERRORS[] = {
+    "Error: Head of expression is not a symbol.",
+    "Error: Incorrect number of arguments for 'if'.",
+    "Error: Incorrect use of 'define'.",
+    "Error: Cannot redefine special form or built-in symbol."
+  };
+
+  // a node for exp, without its children
+  ResolvedNode resolveNode(const Expression & exp, Environment & env)
+  {
+    ResolvedNode node;
+    node.form = Form::Constant;
+    node.operand = 0;
+    node.constant = &exp;
+
+    // An atom is looked up if it is a symbol and is its own value if not
+    if (exp.tail.empty())
+    {
+      if (exp.head.type == SymbolType)
+      {
+        node.form = Form::Variable;
+        node.operand = env.slot(exp.head.value.sym_value);
+      }
+      return node;
+    }
+
+    if (exp.head.type != SymbolType)
+    {
+      node.form = Form::Invalid;
+      node.operand = HEAD_NOT_SYMBOL;
+      return node;
+    }
+
+    const Symbol & head = exp.head.value.sym_value;
+    if (head == IF_SYMBOL)
+    {
+      node.form = exp.tail.size() == 3 ? Form::If : Form::Invalid;
+      node.operand = IF_ARGUMENTS;
+    }
+    else if (head == BEGIN_SYMBOL)
+    {
+      node.form = Form::Begin;
+    }
+    else if (head == DEFINE_SYMBOL)
+    {
+      if (exp.tail.size() != 2 || exp.tail[0].head.type != SymbolType)
+      {
+        node.form = Form::Invalid;
+        node.operand = DEFINE_USE;
+        return node;
+      }
+      const Symbol & name = exp.tail[0].head.value.sym_value;
+      node.form = isReservedSymbol(name) ? Form::DefineReserved : Form::Define;
+      node.operand = env.slot(name);
+    }
+    else
+    {
+      node.form = Form::Call;
+      node.operand = env.slot(head);
+    }
+    return node;
+  }
+
+  // the forms evaluated from their children
+  bool hasChildren(Form form) noexcept
+  {
+    return form == Form::If || form == Form::Begin || form == Form::Define || form == Form::Call;
+  }
+}
+
+const char * resolveErrorMessage(std::uint32_t error) noexcept
+{
+  return RESOLVE_ERRORS[error];
+}
+
+void resolveProgram(const Expression & ast, Environment & env, ResolvedProgram & program,
+  bool shareTails, std::size_t sizeHint)
+{
+  std::vector<ResolvedNode> & nodes = program.nodes;
+  nodes.clear();
+  nodes.reserve(sizeHint);
+  nodes.push_back(resolveNode(ast, env));
+
+  // Nodes whose children are still to be made, with the expressions they
+  // were resolved from, and with shareTails the children made for each
+  // tail
+  struct Pending
+  {
+    const Expression * exp;
+    std::uint32_t index;
+  };
+  std::vector<Pending> pending;
+  std::unordered_map<const Expression *, ResolvedChildren> tails;
+
+  if (hasChildren(nodes.front().form))
+  {
+    pending.push_back({ &ast, 0 });
+  }
+  while (!pending.empty())
+  {
+    const Pending parent = pending.back();
+    pending.pop_back();
+
+    const ExpressionList & tail = parent.exp->tail;
+    ResolvedChildren children{ static_cast<std::uint32_t>(nodes.size()), static_cast<std::uint32_t>(tail.size()) };
+    if (shareTails)
+    {
+      auto found = tails.emplace(tail.begin(), children);
+      if (!found.second && found.first->second.count == children.count)
+      {
+        nodes[parent.index].children = found.first->second;
+        continue;
+      }
+    }
+
+    nodes[parent.index].children = children;
+    for (const Expression & item : tail)
+    {
+      nodes.push_back(resolveNode(item, env));
+    }
+
+    // the first child is taken next, so the AST is read in order
+    for (std::uint32_t i = children.count; i-- > 0;)
+    {
+      if (hasChildren(nodes[children.first + i].form))
+      {
+        pending.push_back({ &tail[i], children.first + i });
+      }
+    }
+  }
+}
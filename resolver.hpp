@@ -0,0 +1,97 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// module includes
+#include "expression.hpp"
+#include "environment.hpp"
+
+// What a resolved node does when it is evaluated
+enum class Form : std::uint8_t
+{
+  Constant,       // a literal, which is its own value
+  Variable,       // the expression bound to the slot
+  If,             // evaluate the first child, then the second or third
+  Begin,          // evaluate the children, the value of the last one
+  Define,         // bind the slot to the value of the second child
+  DefineReserved, // a define of a special form or builtin name
+  Call,           // apply the procedure bound to the slot to the children
+  Invalid         // a malformed form, which fails with its error
+};
+
+// The errors of malformed forms, found when the program is resolved
+// and raised when the form is evaluated
+enum ResolveError : std::uint32_t
+{
+  HEAD_NOT_SYMBOL,
+  IF_ARGUMENTS,
+  DEFINE_USE,
+  DEFINE_RESERVED
+};
+
+// the message a form fails with for error
+const char * resolveErrorMessage(std::uint32_t error) noexcept;
+
+// The nodes of an If, Begin, Define or Call, one for each element of
+// its tail, are the count nodes from first on
+struct ResolvedChildren
+{
+  std::uint32_t first;
+  std::uint32_t count;
+};
+
+struct ResolvedNode
+{
+  Form form;
+  // the environment slot of a Variable, Define, DefineReserved or Call,
+  // the ResolveError of an Invalid node
+  std::uint32_t operand;
+  union
+  {
+    // the expression a Constant was resolved from, its value
+    const Expression * constant;
+    ResolvedChildren children;
+  };
+};
+
+// A program whose special forms are tagged and whose names are bound to
+// slots of the environment it was resolved against, so evaluating it
+// never compares or looks up a name. Constants point into the AST they
+// were resolved from, which must outlive them, or into values
+class ResolvedProgram
+{
+public:
+  std::vector<ResolvedNode> nodes;
+
+  // values computed for the program before it runs, such as folded
+  // constants. A deque, so adding one leaves the others in place
+  std::deque<Expression> values;
+
+  bool empty() const noexcept { return nodes.empty(); }
+  const ResolvedNode & root() const noexcept { return nodes.front(); }
+  const ResolvedNode & child(const ResolvedNode & node, std::size_t i) const noexcept
+  {
+    return nodes[node.children.first + i];
+  }
+
+  void clear() noexcept
+  {
+    nodes.clear();
+    values.clear();
+  }
+};
+
+// Resolve ast against env, giving every name it uses a slot. With
+// shareTails, nodes with the same tail storage share their children, as
+// in hash-consed ASTs. The AST is walked without recursion, so any
+// nesting the parser accepts can be resolved. sizeHint is the number of
+// nodes expected, if known
+void resolveProgram(const Expression & ast, Environment & env, ResolvedProgram & program,
+  bool shareTails = false, std::size_t sizeHint = 0);
+
+#endif
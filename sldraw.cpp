@@ -11,6 +11,14 @@ int main(int argc, char *argv[])
   QApplication app(argc, argv);
 
   std::string filename;
+  QtInterpreter::Evaluator evaluator = QtInterpreter::DEFAULT_EVALUATOR;
+
+  // --vm before the file runs programs on the bytecode VM
+  if(argc > 1 && std::string(argv[1]) == "--vm"){
+    evaluator = QtInterpreter::Evaluator::Bytecode;
+    --argc;
+    ++argv;
+  }
 
   if(argc == 2){
     filename = argv[1];
@@ -20,7 +28,7 @@ int main(int argc, char *argv[])
     return EXIT_FAILURE;
   }
 
-  MainWindow w(filename);
+  MainWindow w(filename, evaluator);
   w.setMinimumSize(800,600);
   w.show();
 
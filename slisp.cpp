@@ -3,14 +3,45 @@
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define SLISP_ISATTY(fd) isatty(fd)
+#elif defined(_WIN32)
+#include <io.h>
+#define SLISP_ISATTY(fd) _isatty(fd)
+#else
+#define SLISP_ISATTY(fd) 1
+#endif
 
 #include "interpreter_semantic_error.hpp"
 #include "interpreter.hpp"
 #include "expression.hpp"
+#include "program_file.hpp"
+#include "form_reader.hpp"
+#include "mapped_file.hpp"
 #include "test_config.hpp"
 using namespace std;
 
 
+// Function to list the nodes folded in the program evaluated last, and
+// how often the memo cache was hit so far
+void print_reports(const Interpreter& interp)
+{
+	static const char* const KINDS[] = { "call", "global", "branch" };
+	for (const FoldedNode& node : interp.foldReport())
+	{
+		cerr << "Folded " << KINDS[static_cast<int>(node.kind)] << ": " << *node.source << " => (" << node.value << ")" << endl;
+	}
+
+	const MemoStats memo = interp.memoStats();
+	if (memo.hits + memo.misses > 0)
+	{
+		cerr << "Memo: " << memo.hits << " hits, " << memo.misses << " misses (" << 100 * memo.hitRate() << "% hit rate)" << endl;
+	}
+}
+
 // Function to execute a short simple program with the -e flag
 int short_program(Interpreter& interp, const string& program)
 {
@@ -20,6 +51,7 @@ int short_program(Interpreter& interp, const string& program)
 		try
 		{
 			Expression result = interp.eval();
+			print_reports(interp);
 			cout << "(" << result << ")" << endl;
 			return EXIT_SUCCESS;
 		}
@@ -36,21 +68,74 @@ int short_program(Interpreter& interp, const string& program)
 	}
 }
 
+// Function to execute the top level forms of a program one at a time
+// each form is evaluated and its result printed as soon as it is read,
+// so a stream only has one form in memory at a time
+int stream_forms(Interpreter& interp, FormReader& reader)
+{
+	string_view form;
+	bool any = false;
+	while (reader.next(form))
+	{
+		any = true;
+		if (!interp.parse(form))
+		{
+			cerr << "Error: Failed to parse." << endl;
+			return EXIT_FAILURE;
+		}
+
+		try
+		{
+			Expression result = interp.eval();
+			print_reports(interp);
+			cout << "(" << result << ")" << endl;
+		}
+		catch (const exception& e)
+		{
+			cerr << "Error: " << e.what() << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!any)
+	{
+		cerr << "Error: Failed to parse." << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 // Function to execute a program stored in an external file
+// the file can hold source or a program compiled with --compile
 int external_file(Interpreter& interp, const string& filename)
 {
-	ifstream ifs(filename);
-	if (!ifs)
+	// Regular files are mapped and parsed in place, anything else, such
+	// as a pipe, is streamed
+	MappedFile file(filename, false);
+	if (!file.isOpen())
 	{
-		cerr << "Error: Cannot open file." << endl;
-		return EXIT_FAILURE;
+		ifstream ifs(filename);
+		if (!ifs)
+		{
+			cerr << "Error: Cannot open file." << endl;
+			return EXIT_FAILURE;
+		}
+		FormReader reader(ifs);
+		return stream_forms(interp, reader);
 	}
 
-	if (interp.parse(ifs))
+	if (!isProgramFile(file.data()))
+	{
+		FormReader reader(file.data());
+		return stream_forms(interp, reader);
+	}
+
+	if (interp.loadProgram(file.data()))
 	{
 		try
 		{
 			Expression result = interp.eval();
+			print_reports(interp);
 			cout << "(" << result << ")" << endl;
 			return EXIT_SUCCESS;
 		}
@@ -67,6 +152,33 @@ int external_file(Interpreter& interp, const string& filename)
 	}
 }
 
+// Function to compile a program to the binary format loaded by external_file
+int compile_file(Interpreter& interp, const string& input, const string& output)
+{
+	// The file is opened once, and parsed from its mapped pages
+	MappedFile file(input);
+	if (!file.isOpen())
+	{
+		cerr << "Error: Cannot open file." << endl;
+		return EXIT_FAILURE;
+	}
+
+	if (!interp.parseFile(file))
+	{
+		cerr << "Error: Failed to parse." << endl;
+		return EXIT_FAILURE;
+	}
+
+	ofstream ofs(output, ios::binary);
+	interp.saveProgram(ofs);
+	if (!ofs)
+	{
+		cerr << "Error: Cannot write file." << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 // Function to run in interactive REPL mode
 int interactive_repl(Interpreter& interp)
 {
@@ -90,6 +202,7 @@ int interactive_repl(Interpreter& interp)
 			try
 			{
 				Expression result = interp.eval();
+				print_reports(interp);
 				cout << "(" << result << ")" << endl;
 			}
 			catch (const exception& e)
@@ -110,19 +223,55 @@ int main(int argc, char** argv)
 {
 	Interpreter interp;
 
+	// --vm before the other arguments runs programs on the bytecode VM,
+	// --fold folds their constants first, listing what was folded, and
+	// --memo keeps the values of costly builtins, reporting the hit rate
+	for (; argc > 1; --argc, ++argv)
+	{
+		if (std::string(argv[1]) == "--vm")
+		{
+			interp.setEvaluator(Interpreter::Evaluator::Bytecode);
+		}
+		else if (std::string(argv[1]) == "--fold")
+		{
+			interp.setFolding(true, true);
+		}
+		else if (std::string(argv[1]) == "--memo")
+		{
+			interp.setMemoization(DEFAULT_MEMO_ENTRIES);
+		}
+		else
+		{
+			break;
+		}
+	}
+
 	// Case 1: Execute short simple programs with the -e flag
 	if (argc == 3 && std::string(argv[1]) == "-e")
 	{
 		return short_program(interp, argv[2]);
 	}
 
-	// Case 2: Execute programs stored in external files
+	// Case 2: Compile a program with --compile in.slp -o out.slc
+	if (argc == 5 && std::string(argv[1]) == "--compile" && std::string(argv[3]) == "-o")
+	{
+		return compile_file(interp, argv[2], argv[4]);
+	}
+
+	// Case 3: Execute the forms piped to stdin, or given with -
+	if ((argc == 2 && std::string(argv[1]) == "-") || (argc == 1 && !SLISP_ISATTY(fileno(stdin))))
+	{
+		FormReader reader(cin);
+		return stream_forms(interp, reader);
+	}
+
+	// Case 4: Execute programs stored in external files
 	if (argc == 2)
 	{
 		return external_file(interp, argv[1]);
 	}
 
-	// Case 3: Interactive REPL mode
+	// Case 5: Interactive REPL mode
 	if (argc == 1)
 	{
 		return interactive_repl(interp);
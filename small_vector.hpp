@@ -0,0 +1,151 @@
+#ifndef SMALL_VECTOR_HPP
+#define SMALL_VECTOR_HPP
+
+// system includes
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// A SmallVector is a growable array whose first N elements are stored
+// inside the object itself, so short lists need no heap allocation. It
+// moves to the heap only once it holds more than N elements. It is meant
+// for scratch lists local to one call, so it can not be copied
+template<typename T, std::size_t N>
+class SmallVector
+{
+public:
+  typedef T * iterator;
+  typedef const T * const_iterator;
+
+  SmallVector() noexcept: items(inlineItems()), count(0), capacity(N){};
+  SmallVector(const SmallVector &) = delete;
+  SmallVector & operator=(const SmallVector &) = delete;
+
+  ~SmallVector()
+  {
+    clear();
+    if (items != inlineItems())
+    {
+      ::operator delete(items);
+    }
+  }
+
+  bool empty() const noexcept { return count == 0; }
+  std::size_t size() const noexcept { return count; }
+
+  T * data() noexcept { return items; }
+  const T * data() const noexcept { return items; }
+
+  T & operator[](std::size_t i) noexcept { return items[i]; }
+  const T & operator[](std::size_t i) const noexcept { return items[i]; }
+
+  T & back() noexcept { return items[count - 1]; }
+  const T & back() const noexcept { return items[count - 1]; }
+
+  iterator begin() noexcept { return items; }
+  iterator end() noexcept { return items + count; }
+  const_iterator begin() const noexcept { return items; }
+  const_iterator end() const noexcept { return items + count; }
+
+  void reserve(std::size_t wanted)
+  {
+    if (wanted > capacity)
+    {
+      grow(wanted);
+    }
+  }
+
+  template<typename... Args>
+  T & emplace_back(Args &&... args)
+  {
+    if (count == capacity)
+    {
+      return growAndEmplace(std::forward<Args>(args)...);
+    }
+    T * item = new (items + count) T(std::forward<Args>(args)...);
+    ++count;
+    return *item;
+  }
+
+  void push_back(const T & item) { emplace_back(item); }
+  void push_back(T && item) { emplace_back(std::move(item)); }
+
+  void pop_back() noexcept
+  {
+    --count;
+    items[count].~T();
+  }
+
+  // destroy the elements from index size on, keeping the storage
+  void truncate(std::size_t size) noexcept
+  {
+    while (count > size)
+    {
+      pop_back();
+    }
+  }
+
+  void clear() noexcept { truncate(0); }
+
+private:
+  T * inlineItems() noexcept { return reinterpret_cast<T *>(storage); }
+
+  // Grow and add an element. The arguments may refer to an element of
+  // this vector, so the new element is built before the old ones move
+  template<typename... Args>
+  T & growAndEmplace(Args &&... args)
+  {
+    const std::size_t wanted = 2 * capacity;
+    T * moved = static_cast<T *>(::operator new(wanted * sizeof(T)));
+    T * item;
+    try
+    {
+      item = new (moved + count) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      ::operator delete(moved);
+      throw;
+    }
+    try
+    {
+      std::uninitialized_move(items, items + count, moved);
+    }
+    catch (...)
+    {
+      item->~T();
+      ::operator delete(moved);
+      throw;
+    }
+    std::destroy(items, items + count);
+    if (items != inlineItems())
+    {
+      ::operator delete(items);
+    }
+    items = moved;
+    capacity = wanted;
+    ++count;
+    return *item;
+  }
+
+  void grow(std::size_t wanted)
+  {
+    T * moved = static_cast<T *>(::operator new(wanted * sizeof(T)));
+    std::uninitialized_move(items, items + count, moved);
+    std::destroy(items, items + count);
+    if (items != inlineItems())
+    {
+      ::operator delete(items);
+    }
+    items = moved;
+    capacity = wanted;
+  }
+
+  alignas(T) unsigned char storage[N * sizeof(T)];
+  T * items;
+  std::size_t count;
+  std::size_t capacity;
+};
+
+#endif
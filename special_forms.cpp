@@ -0,0 +1,15 @@
+#include "special_forms.hpp"
+
+// system includes
+#include <algorithm>
+#include <iterator>
+
+const Symbol IF_SYMBOL("if");
+const Symbol BEGIN_SYMBOL("begin");
+const Symbol DEFINE_SYMBOL("define");
+
+bool isReservedSymbol(const Symbol & symbol) noexcept
+{
+  static const Symbol RESERVED[] = { DEFINE_SYMBOL, IF_SYMBOL, BEGIN_SYMBOL, "pi", "+", "-", "*", "/" };
+  return std::find(std::begin(RESERVED), std::end(RESERVED), symbol) != std::end(RESERVED);
+}
@@ -0,0 +1,16 @@
+#ifndef SPECIAL_FORMS_HPP
+#define SPECIAL_FORMS_HPP
+
+// module includes
+#include "symbol.hpp"
+
+// Special forms, interned once so evaluators compare symbol ids
+// instead of strings
+extern const Symbol IF_SYMBOL;
+extern const Symbol BEGIN_SYMBOL;
+extern const Symbol DEFINE_SYMBOL;
+
+// true for the special forms and the built-in names define may not bind
+bool isReservedSymbol(const Symbol & symbol) noexcept;
+
+#endif
@@ -0,0 +1,139 @@
+#include "symbol.hpp"
+
+// system includes
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+	// Index of the highest set bit of a non-zero value
+	inline unsigned highestBit(std::uint64_t value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+		unsigned i = 0;
+		while (value >>= 1)
+		{
+			++i;
+		}
+		return i;
+#endif
+	}
+
+	// The table of interned names. Names live in chunks that are never
+	// moved or freed, each twice the size of the one before, so a name
+	// stays where it was put and the map keys view it. Symbols can be
+	// created from several threads, so interning is locked. A name is
+	// written before its id is handed out and never changes after, and
+	// a chunk is published before any id in it, so reading a name takes
+	// no lock
+	class SymbolTable
+	{
+	public:
+		SymbolTable()
+		{
+			intern(std::string_view());
+		}
+
+		~SymbolTable()
+		{
+			for (std::atomic<std::string *> & chunk : chunks)
+			{
+				delete[] chunk.load(std::memory_order_relaxed);
+			}
+		}
+
+		Symbol::IdType intern(std::string_view name)
+		{
+			// Each thread remembers the names it interned recently, so the
+			// common case of a repeated name does not take the lock. Names
+			// are never removed or changed, so the pointers stay valid
+			struct Recent
+			{
+				const std::string * name;
+				Symbol::IdType id;
+			};
+			thread_local Recent recent[RECENT_SIZE] = {};
+
+			Recent & slot = recent[std::hash<std::string_view>()(name) % RECENT_SIZE];
+			if (slot.name != nullptr && *slot.name == name)
+			{
+				return slot.id;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto it = ids.find(name);
+			if (it != ids.end())
+			{
+				slot = { &entry(it->second), it->second };
+				return it->second;
+			}
+
+			const Symbol::IdType id = count;
+			const std::uint64_t position = std::uint64_t(id) + FIRST_CHUNK;
+			const unsigned chunk = highestBit(position) - FIRST_CHUNK_BITS;
+			if (chunks[chunk].load(std::memory_order_relaxed) == nullptr)
+			{
+				chunks[chunk].store(new std::string[FIRST_CHUNK << chunk], std::memory_order_release);
+			}
+			std::string & stored = entry(id);
+			stored.assign(name.data(), name.size());
+			++count;
+			ids.emplace(stored, id);
+			slot = { &stored, id };
+			return id;
+		}
+
+		const std::string & name(Symbol::IdType id) const noexcept
+		{
+			return entry(id);
+		}
+
+	private:
+		// where the name with id is kept
+		std::string & entry(Symbol::IdType id) const noexcept
+		{
+			const std::uint64_t position = std::uint64_t(id) + FIRST_CHUNK;
+			const unsigned chunk = highestBit(position) - FIRST_CHUNK_BITS;
+			return chunks[chunk].load(std::memory_order_acquire)[position - (FIRST_CHUNK << chunk)];
+		}
+
+		static const std::size_t RECENT_SIZE = 1024;
+
+		// Chunks of 1024 names and up, enough of them for every 32-bit id
+		static const unsigned FIRST_CHUNK_BITS = 10;
+		static const std::uint64_t FIRST_CHUNK = std::uint64_t(1) << FIRST_CHUNK_BITS;
+		static const unsigned CHUNKS = 33 - FIRST_CHUNK_BITS;
+
+		std::mutex mutex;
+		std::atomic<std::string *> chunks[CHUNKS] = {};
+		Symbol::IdType count = 0;
+		std::unordered_map<std::string_view, Symbol::IdType> ids;
+	};
+
+	// Constructed on first use, so symbols can be created during static
+	// initialization of other modules
+	SymbolTable & table()
+	{
+		static SymbolTable symbols;
+		return symbols;
+	}
+}
+
+Symbol::Symbol(std::string_view name): symbol_id(table().intern(name))
+{
+}
+
+const std::string & Symbol::str() const
+{
+	return table().name(symbol_id);
+}
+
+std::ostream & operator<<(std::ostream & out, const Symbol & sym)
+{
+	return out << sym.str();
+}
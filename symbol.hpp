@@ -0,0 +1,50 @@
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+// system includes
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// A Symbol is an id into a global table of interned names, so every
+// distinct name is stored once and symbols compare as integers
+class Symbol
+{
+public:
+  typedef std::uint32_t IdType;
+
+  // the empty name
+  Symbol() noexcept: symbol_id(0){};
+
+  // intern name, returning the existing id if it was seen before
+  Symbol(std::string_view name);
+  Symbol(const std::string & name): Symbol(std::string_view(name)){};
+  Symbol(const char * name): Symbol(std::string_view(name)){};
+
+  IdType id() const noexcept { return symbol_id; }
+
+  // the interned name, valid for the lifetime of the program. Reading
+  // it takes no lock
+  const std::string & str() const;
+
+  bool operator==(const Symbol & sym) const noexcept { return symbol_id == sym.symbol_id; }
+  bool operator!=(const Symbol & sym) const noexcept { return symbol_id != sym.symbol_id; }
+
+private:
+  IdType symbol_id;
+};
+
+// format a symbol as its name
+std::ostream & operator<<(std::ostream & out, const Symbol & sym);
+
+namespace std
+{
+  template<> struct hash<Symbol>
+  {
+    std::size_t operator()(const Symbol & sym) const noexcept { return sym.id(); }
+  };
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
 
 #include "interpreter_semantic_error.hpp"
 #include "interpreter.hpp"
@@ -108,6 +111,64 @@ TEST_CASE( "Test Interpreter parser with extra input", "[interpreter]" ) {
   REQUIRE(ok == false);
 }
 
+TEST_CASE( "Test Interpreter parser with deeply nested input", "[interpreter]" ) {
+
+  const int depth = 50000;
+  std::string program;
+  for(int i = 0; i < depth; ++i){
+    program += "(- ";
+  }
+  program += "1";
+  program += std::string(depth, ')');
+
+  std::istringstream iss(program);
+
+  Interpreter interp;
+
+  bool ok = interp.parse(iss);
+
+  REQUIRE(ok == true);
+}
+
+TEST_CASE( "Test Interpreter evaluates deeply nested input", "[interpreter]" ) {
+
+  // calls, begins and ifs nested as deep as generated drawings get,
+  // evaluated end to end by each evaluator, with and without folding
+  const int depth = 100000;
+  std::string program;
+  int calls = 0;
+  for(int i = 0; i < depth; ++i){
+    switch(i % 3){
+    case 0:
+      program += "(+ 1 ";
+      ++calls;
+      break;
+    case 1:
+      program += "(begin ";
+      break;
+    default:
+      program += "(if True ";
+      break;
+    }
+  }
+  program += "1";
+  for(int i = depth; i-- > 0;){
+    program += i % 3 == 2 ? " 0)" : ")";
+  }
+
+  for (Interpreter::Evaluator evaluator : {Interpreter::Evaluator::Tree, Interpreter::Evaluator::Bytecode})
+  {
+    for (bool folding : {false, true})
+    {
+      Interpreter interp;
+      interp.setEvaluator(evaluator);
+      interp.setFolding(folding);
+      REQUIRE(interp.parse(program));
+      REQUIRE(interp.eval() == Expression(calls + 1.));
+    }
+  }
+}
+
 TEST_CASE( "Test Interpreter parser with single non-keyword", "[interpreter]" ) {
 
   std::string program = "hello";
@@ -486,3 +547,531 @@ TEST_CASE( "Test all syntactically and semantically CORRECT files.", "[interpret
   }
 }
 
+
+TEST_CASE( "Test compiled program round trip", "[interpreter]" ) {
+
+  std::string program = "(begin (define r 10) (define big 1e300) (if (< r -2.5) (draw (point 0 0)) (* pi (* r r))))";
+  std::string fname = "test_round_trip.slc";
+
+  {
+    std::istringstream iss(program);
+    Interpreter interp;
+    REQUIRE(interp.parse(iss));
+
+    std::ofstream ofs(fname, std::ios::binary);
+    interp.saveProgram(ofs);
+  }
+
+  Interpreter interp;
+  REQUIRE(interp.loadProgram(fname));
+  REQUIRE(interp.eval() == run(program));
+
+  // a truncated program is rejected instead of half loaded
+  {
+    std::ofstream ofs(fname, std::ios::binary | std::ios::trunc);
+    ofs << "SLC";
+  }
+  REQUIRE_FALSE(interp.loadProgram(fname));
+
+  // so is a program claiming more nodes or a longer tail than it has bytes
+  {
+    std::istringstream iss("(+ 1 2)");
+    Interpreter small;
+    REQUIRE(small.parse(iss));
+    std::ostringstream oss;
+    small.saveProgram(oss);
+    const std::string image = oss.str();
+
+    // the header ends with the node count, then "+" is the one symbol and
+    // the first node is its index and a tail of 2
+    std::string nodes = image;
+    nodes.replace(12, 4, "\xFF\xFF\xFF\xFF", 4);
+    REQUIRE_FALSE(interp.loadProgram(std::string_view(nodes)));
+
+    std::string tail = image;
+    REQUIRE(tail[20] == 2);
+    tail.replace(12, 4, "\xFF\xFF\xFF\xFF", 4);
+    tail.replace(20, 1, "\xFE\xFF\xFF\xFF\x0F", 5);
+    REQUIRE_FALSE(interp.loadProgram(std::string_view(tail)));
+    REQUIRE(interp.loadProgram(std::string_view(image)));
+    REQUIRE(interp.eval() == Expression(3.));
+  }
+
+  std::remove(fname.c_str());
+}
+
+TEST_CASE( "Test parse cache reuses the AST of repeated input", "[interpreter]" ) {
+
+  std::string program = "(begin (define r 10) (* pi (* r r)))";
+  Interpreter interp;
+
+  // the cache is off until it is given limits
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.parseCache().hits() == 0);
+  REQUIRE(interp.parseCache().misses() == 0);
+  REQUIRE(interp.parseCache().size() == 0);
+
+  interp.parseCache().setLimits(DEFAULT_PARSE_CACHE_ENTRIES, DEFAULT_PARSE_CACHE_BYTES);
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.parseCache().misses() == 1);
+  REQUIRE(interp.eval() == Expression(atan2(0, -1) * 100));
+
+  interp.resetEnvironment();
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.parseCache().hits() == 1);
+  REQUIRE(interp.eval() == Expression(atan2(0, -1) * 100));
+
+  REQUIRE(interp.parse(std::string("(+ 1 2)")));
+  REQUIRE(interp.parseCache().misses() == 2);
+  REQUIRE(interp.parseCache().size() == 2);
+
+  // the ASTs of the other parse mode are not reused
+  interp.setHashConsing(true);
+  REQUIRE(interp.parseCache().size() == 0);
+  REQUIRE(interp.parse(std::string("(+ 1 2)")));
+  REQUIRE(interp.parseCache().misses() == 3);
+  REQUIRE(interp.parse(std::string("(+ 1 2)")));
+  REQUIRE(interp.parseCache().hits() == 2);
+  REQUIRE(interp.eval() == Expression(3.));
+  interp.setHashConsing(false);
+  REQUIRE(interp.parse(std::string("(+ 1 2)")));
+  REQUIRE(interp.parseCache().misses() == 4);
+
+  // a disabled cache neither stores nor counts
+  interp.parseCache().setLimits(0, 0);
+  REQUIRE(interp.parseCache().size() == 0);
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.parseCache().hits() == 2);
+
+  // an entry is only taken for the text it was parsed from, so inputs
+  // whose keys collide never share a tree
+  ParseCache cache(DEFAULT_PARSE_CACHE_ENTRIES, DEFAULT_PARSE_CACHE_BYTES);
+  const ParseCache::Key key = ParseCache::keyOf("(+ 1 2)");
+  cache.insert(key, "(+ 1 2)", { nullptr, Expression(3.) });
+  ParseCache::Entry found;
+  REQUIRE_FALSE(cache.find(key, "(+ 2 1)", found));
+  REQUIRE(cache.misses() == 1);
+  REQUIRE(cache.find(key, "(+ 1 2)", found));
+  REQUIRE(found.ast == Expression(3.));
+}
+
+TEST_CASE( "Test parallel parse of a large program", "[interpreter]" ) {
+
+  // enough top level forms to be split into several pieces
+  std::string program = "(begin ; many forms\n  (define x 7) (define y 6)\n";
+  while (program.size() < Interpreter::PARALLEL_PARSE_MIN)
+  {
+    program += "  (+ x (* 2 3)) ; (\n  (- x y) True\n";
+  }
+  program += "  (+ x y))";
+
+  Interpreter interp;
+  interp.setParseThreads(4);
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.eval() == Expression(13.));
+
+  std::ostringstream parallel;
+  interp.saveProgram(parallel);
+
+  Interpreter sequential;
+  sequential.setParseThreads(1);
+  REQUIRE(sequential.parse(program));
+  std::ostringstream single;
+  sequential.saveProgram(single);
+  REQUIRE(parallel.str() == single.str());
+
+  // an error inside one of the pieces fails the whole parse
+  std::string broken = program;
+  broken.insert(broken.find("(+", broken.size() / 2), "(1 2)");
+  REQUIRE_FALSE(interp.parse(broken));
+  REQUIRE_FALSE(interp.parse(program + "(+ 1 2)"));
+}
+
+// an Interpreter that shows the program it parsed
+class ProgramProbe: public Interpreter
+{
+public:
+  const Expression & program() const noexcept { return ast; }
+};
+
+TEST_CASE( "Test hash-consed parse of a repetitive program", "[interpreter]" ) {
+
+  std::string small = "(begin (define r 2) (+ (* r (* pi 2)) (* r (* pi 2))))";
+  std::string large = "(begin (define z 1)\n";
+  while (large.size() < Interpreter::FORM_PARSE_MIN)
+  {
+    large += "  (draw (arc (point 0 0) (point 10 z) (* pi 2)))\n";
+  }
+  large += "  (+ z (* pi 2)))";
+
+  for (const std::string & program : { small, large })
+  {
+    Interpreter plain;
+    plain.parseCache().setLimits(0, 0);
+    REQUIRE(plain.parse(program));
+    std::ostringstream plainImage;
+    plain.saveProgram(plainImage);
+
+    // the shared nodes read and run exactly like the unshared ones
+    Interpreter shared;
+    shared.parseCache().setLimits(0, 0);
+    shared.setHashConsing(true);
+    REQUIRE(shared.parse(program));
+    std::ostringstream sharedImage;
+    shared.saveProgram(sharedImage);
+
+    REQUIRE(sharedImage.str() == plainImage.str());
+    REQUIRE(shared.eval() == plain.eval());
+  }
+
+  // forms kept from a parse in the other mode are parsed again, so the
+  // repeated forms share their nodes
+  ProgramProbe switched;
+  switched.parseCache().setLimits(0, 0);
+  REQUIRE(switched.parse(large));
+  REQUIRE(switched.program().tail[1].tail.begin() != switched.program().tail[2].tail.begin());
+  switched.setHashConsing(true);
+  REQUIRE(switched.parse(large));
+  REQUIRE(switched.program().tail[1].tail.begin() == switched.program().tail[2].tail.begin());
+}
+
+// the value of program, or the error it fails with
+static std::string evaluateWith(Interpreter::Evaluator evaluator, const std::string & program)
+{
+  Interpreter interp;
+  interp.setEvaluator(evaluator);
+  if (!interp.parse(program))
+  {
+    return "parse failed";
+  }
+  try
+  {
+    std::ostringstream out;
+    out << interp.eval();
+    return out.str();
+  }
+  catch (const InterpreterSemanticError & error)
+  {
+    return error.what();
+  }
+}
+
+TEST_CASE( "Test bytecode evaluator matches the tree evaluator", "[interpreter]" ) {
+
+  const std::string programs[] = {
+    "(begin (define r 10) (* pi (* r r)))",
+    "(+ 1 2 3 4 5 6)",
+    "(if (< 1 2) (if False 1 (- 7)) 3)",
+    "(begin (define a 1) (define b (+ a 1)) (if (> b a) (arc (point 0 0) (point b 0) pi) a))",
+    "(begin (define a #[1 2.5 -3e2]) (+ (nth a 1) (length a)))",
+    "(draw (line (point 0 0) (point 10 0)))",
+    "(begin (define log10 5) (+ log10 1))",
+    "(begin (define x 1) (define x 2))",
+    "(begin (define pi 3))",
+    "(begin (define + 3))",
+    "(define 1 2)",
+    "(begin (define y (+ 1 z)))",
+    "(if 1 2 3)",
+    "(if True 2)",
+    "(+ 1 (unknown 2) (if 1 2 3))",
+    "(begin (define log10 5) (log10 2))",
+    "(begin)",
+    "(/ 1 0)",
+    "(+ True 1)",
+  };
+
+  for (const std::string & program : programs)
+  {
+    INFO(program);
+    REQUIRE(evaluateWith(Interpreter::Evaluator::Bytecode, program) == evaluateWith(Interpreter::Evaluator::Tree, program));
+  }
+
+  // the compiler keeps no call stack per level, so deep programs run on
+  // the VM too
+  const std::size_t depth = 20000;
+  std::string deep;
+  for (std::size_t i = 0; i < depth; ++i)
+  {
+    deep += "(+ 1 ";
+  }
+  deep += "1" + std::string(depth, ')');
+  std::ostringstream expected;
+  expected << Expression(depth + 1.);
+  REQUIRE(evaluateWith(Interpreter::Evaluator::Bytecode, deep) == expected.str());
+}
+
+TEST_CASE( "Test resolution binds names to slots", "[interpreter]" ) {
+
+  Interpreter interp;
+  {
+    Lexer lexer("(begin (define a 1) (if (< a 2) (+ a pi) (if a)) (define + 1))");
+    AstArena arena;
+    Expression ast = interp.parseExpression(lexer, arena);
+    Environment env;
+
+    ResolvedProgram program;
+    resolveProgram(ast, env, program);
+    const ResolvedNode & root = program.root();
+    REQUIRE(root.form == Form::Begin);
+    REQUIRE(root.children.count == 3);
+
+    const ResolvedNode & define = program.child(root, 0);
+    REQUIRE(define.form == Form::Define);
+    REQUIRE(define.operand == env.slot("a"));
+    REQUIRE(program.child(define, 1).form == Form::Constant);
+
+    const ResolvedNode & branch = program.child(root, 1);
+    REQUIRE(branch.form == Form::If);
+    const ResolvedNode & test = program.child(branch, 0);
+    REQUIRE(test.form == Form::Call);
+    REQUIRE(test.operand == env.slot("<"));
+    REQUIRE(program.child(test, 0).form == Form::Variable);
+    REQUIRE(program.child(test, 0).operand == env.slot("a"));
+    REQUIRE(program.child(program.child(branch, 1), 1).operand == env.slot("pi"));
+    REQUIRE(program.child(branch, 2).form == Form::Invalid);
+    REQUIRE(program.child(branch, 2).operand == IF_ARGUMENTS);
+
+    REQUIRE(program.child(root, 2).form == Form::DefineReserved);
+  }
+
+  // the program is resolved again against a reset environment
+  REQUIRE(interp.parse(std::string("(begin (define b 2) (+ b 1))")));
+  REQUIRE(interp.eval() == Expression(3.));
+  interp.resetEnvironment();
+  REQUIRE(interp.eval() == Expression(3.));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+}
+
+TEST_CASE( "Test folding constants before evaluation", "[interpreter]" ) {
+
+  const std::string programs[] = {
+    "(begin (define r 2) (define a (* pi (* r r))) (if (< a 20) (sin (/ pi 4)) (cos a)))",
+    "(begin (if (< 1 2) (define x 1) (define x 2)) (+ x 1))",
+    "(begin (define y (< 1 2)) (if y (define z 1) (define z 2)) (if y z 0))",
+    "(begin (define cos 2) (+ cos 1))",
+    "(draw (point 0 0) (line (point 1 1) (point (/ 2 1) 2)))"
+  };
+  for (const std::string & program : programs)
+  {
+    Expression expected = run(program);
+    for (Interpreter::Evaluator evaluator : { Interpreter::Evaluator::Tree, Interpreter::Evaluator::Bytecode })
+    {
+      Interpreter interp;
+      interp.setFolding(true);
+      interp.setEvaluator(evaluator);
+      REQUIRE(interp.parse(program));
+      REQUIRE(interp.eval() == expected);
+      REQUIRE(interp.foldCount() > 0);
+      REQUIRE(interp.foldReport().empty());
+    }
+  }
+
+  {
+    // The whole program folds, the branch not taken is dropped
+    Interpreter interp;
+    interp.setFolding(true, true);
+    REQUIRE(interp.parse(programs[0]));
+    REQUIRE(interp.eval() == Expression(std::sin(std::atan2(0, -1) / 4)));
+    const std::vector<FoldedNode> & report = interp.foldReport();
+    REQUIRE(report.back().kind == FoldKind::Branch);
+    REQUIRE(report.back().value == Expression(true));
+    REQUIRE(std::count_if(report.begin(), report.end(), [](const FoldedNode & node) { return node.kind == FoldKind::Call; }) == 5);
+  }
+
+  {
+    // z is defined in a branch that is not known to run, so it stays a
+    // name, and calls that fail are left to fail when the program runs
+    Interpreter interp;
+    interp.setFolding(true, true);
+    REQUIRE(interp.parse(std::string("(begin (if (= (define w 1) 1) (define z 1) (define z 2)) (+ z (/ 1 0)))")));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+    REQUIRE(interp.foldReport().empty());
+    REQUIRE(interp.isSymbolStringDefined("z"));
+  }
+
+  {
+    // names defined by an earlier program are folded into later ones,
+    // procedures the program defines anew are not called early
+    Interpreter interp;
+    interp.setFolding(true, true);
+    REQUIRE(interp.parse(std::string("(define r 3)")));
+    REQUIRE(interp.eval() == Expression(3.));
+    REQUIRE(interp.parse(std::string("(begin (define sin 1) (sin r))")));
+    REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+    REQUIRE(interp.foldReport().size() == 1);
+    REQUIRE(interp.foldReport()[0].kind == FoldKind::Global);
+
+    // the report goes with the program it was made for
+    REQUIRE(interp.parse(std::string("(+ 1 2)")));
+    REQUIRE(interp.foldReport().empty());
+    REQUIRE(interp.foldCount() == 0);
+  }
+}
+
+// an Interpreter whose kept form spans can be made to collide
+class FormProbe: public Interpreter
+{
+public:
+  // make the first kept span holding from hash as its text would with
+  // from replaced by to
+  void collide(const std::string & from, const std::string & to)
+  {
+    for (FormSpan & span : formSpans)
+    {
+      std::string text = formSource.substr(span.offset, span.length);
+      const std::size_t at = text.find(from);
+      if (at != std::string::npos)
+      {
+        text.replace(at, from.size(), to);
+        span.hash = TextHash(text);
+        return;
+      }
+    }
+  }
+};
+
+TEST_CASE( "Test reparse of an edited large program", "[interpreter]" ) {
+
+  std::string program = "(begin\n  (define x 1)\n";
+  while (program.size() < Interpreter::FORM_PARSE_MIN)
+  {
+    program += "  (+ x (* 2 3)) ; form\n";
+  }
+  program += "  (+ x 1))";
+
+  Interpreter interp;
+  interp.parseCache().setLimits(0, 0);
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.eval() == Expression(2.));
+
+  // change the first and the last form, and move one in the middle
+  std::string edited = program;
+  edited.replace(edited.find("(define x 1)"), 12, "(define x 10)");
+  edited.replace(edited.rfind("(+ x 1)"), 7, "(- x 1)");
+  edited.insert(edited.find("(+ x (* 2 3))", edited.size() / 2), "(+ x 2) ");
+
+  interp.resetEnvironment();
+  REQUIRE(interp.parse(edited));
+  REQUIRE(interp.eval() == Expression(9.));
+
+  std::ostringstream reparsed;
+  interp.saveProgram(reparsed);
+
+  Interpreter fresh;
+  REQUIRE(fresh.parse(edited));
+  std::ostringstream parsed;
+  fresh.saveProgram(parsed);
+  REQUIRE(reparsed.str() == parsed.str());
+
+  // a broken edit is rejected, and the next good one still reuses forms
+  REQUIRE_FALSE(interp.parse(edited + ")"));
+  interp.resetEnvironment();
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.eval() == Expression(2.));
+
+  // a span whose hash collides with the old one is still parsed again
+  FormProbe probe;
+  REQUIRE(probe.parse(program));
+  probe.collide("(define x 1)", "(define x 2)");
+  std::string colliding = program;
+  colliding.replace(colliding.find("(define x 1)"), 12, "(define x 2)");
+  REQUIRE(probe.parse(colliding));
+  REQUIRE(probe.eval() == Expression(3.));
+}
+
+TEST_CASE( "Test array literals", "[interpreter]" ) {
+
+  std::string program = "(begin (define a #[1 2.5\n -3e2 ]) (+ (nth a 1) (length a)))";
+  Interpreter interp;
+  REQUIRE(interp.parse(program));
+  REQUIRE(interp.eval() == Expression(5.5));
+
+  // a defined array outlives the program that read it
+  REQUIRE(interp.parse(std::string("(nth a 2)")));
+  REQUIRE(interp.eval() == Expression(-300.));
+
+  REQUIRE(interp.parse(std::string("(length #[])")));
+  REQUIRE(interp.eval() == Expression(0.));
+
+  REQUIRE(interp.parse(std::string("(nth a 3)")));
+  REQUIRE_THROWS_AS(interp.eval(), InterpreterSemanticError);
+
+  // an array result keeps its numbers after the next parse frees the
+  // program it came from, with either evaluator
+  for (Interpreter::Evaluator evaluator : {Interpreter::Evaluator::Tree, Interpreter::Evaluator::Bytecode})
+  {
+    interp.setEvaluator(evaluator);
+    REQUIRE(interp.parse(std::string("(begin #[7 8 9])")));
+    Expression literal = interp.eval();
+    REQUIRE(interp.parse(std::string("(begin (define b #[4 5]) b)")));
+    Expression defined = interp.eval();
+    REQUIRE(interp.parse(std::string("(+ 1 2)")));
+    REQUIRE(interp.eval() == Expression(3.));
+    std::ostringstream out;
+    out << literal << defined;
+    REQUIRE(out.str() == "#[7 8 9]#[4 5]");
+    interp.resetEnvironment();
+  }
+
+  // and after the interpreter is gone
+  Expression result;
+  {
+    Interpreter scoped;
+    REQUIRE(scoped.parse(std::string("(begin #[1.5 2.5 3.5])")));
+    result = scoped.eval();
+  }
+  std::ostringstream out;
+  out << result;
+  REQUIRE(out.str() == "#[1.5 2.5 3.5]");
+
+  // array literals hold numbers only and must be closed
+  REQUIRE_FALSE(interp.parse(std::string("(length #[1 x])")));
+  REQUIRE_FALSE(interp.parse(std::string("(length #[1 2)")));
+  REQUIRE_FALSE(interp.parse(std::string("(length #[1 2) 3]")));
+  REQUIRE_FALSE(interp.parse(std::string("(#[1] 2)")));
+
+  // arrays survive the compiled format
+  std::string fname = "test_array.slc";
+  REQUIRE(interp.parse(std::string("(draw #[0 1e-300 -0.5 4])")));
+  {
+    std::ofstream ofs(fname, std::ios::binary);
+    interp.saveProgram(ofs);
+  }
+  Interpreter loaded;
+  REQUIRE(loaded.loadProgram(fname));
+  REQUIRE(loaded.eval() == interp.eval());
+  std::remove(fname.c_str());
+}
+
+TEST_CASE( "Test parse of a mapped file", "[interpreter]" ) {
+
+  std::string fname = "test_mapped.slp";
+  {
+    std::ofstream ofs(fname, std::ios::binary);
+    ofs << "; source\n(begin (define r 10) (* r r))\n";
+  }
+
+  // a mapped file is parsed in place, and not copied into the cache
+  Interpreter interp;
+  interp.parseCache().setLimits(DEFAULT_PARSE_CACHE_ENTRIES, DEFAULT_PARSE_CACHE_BYTES);
+  REQUIRE(interp.parseFile(fname));
+  REQUIRE(interp.eval() == Expression(100.));
+  REQUIRE(interp.parseCache().size() == 0);
+  REQUIRE(interp.parseCache().misses() == 0);
+
+  // a compiled program is recognized by its contents
+  std::string cname = "test_mapped.slc";
+  {
+    std::ofstream ofs(cname, std::ios::binary);
+    interp.saveProgram(ofs);
+  }
+  interp.resetEnvironment();
+  REQUIRE(interp.parseFile(cname));
+  REQUIRE(interp.eval() == Expression(100.));
+
+  REQUIRE_FALSE(interp.parseFile("test_missing.slp"));
+
+  std::remove(fname.c_str());
+  std::remove(cname.c_str());
+}
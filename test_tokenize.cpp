@@ -2,8 +2,11 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 
+#include "char_scan.hpp"
 #include "tokenize.hpp"
+#include "form_reader.hpp"
 
 TEST_CASE( "Test Tokenizer with expected input", "[tokenize]" ) {
 
@@ -82,3 +85,202 @@ TEST_CASE( "Test Tokenizer with empty expression", "[tokenize]" ) {
   REQUIRE( tokens[1] == ")" );
 }
 
+
+TEST_CASE( "Test Tokenizer views over a contiguous buffer", "[tokenize]" ) {
+
+  std::string program = "; comment\n(begin (define r 10)\n(* pi (* r r)))";
+
+  TokenViewSequenceType tokens = tokenize(std::string_view(program));
+
+  REQUIRE( tokens.size() == 17 );
+  REQUIRE( tokens[0] == "(" );
+  REQUIRE( tokens[1] == "begin" );
+  REQUIRE( tokens[5] == "10" );
+  REQUIRE( tokens[16] == ")" );
+
+  // the tokens point into the source instead of owning a copy
+  REQUIRE( tokens[1].data() == program.data() + 11 );
+}
+
+TEST_CASE( "Test Lexer pulls tokens on demand", "[tokenize]" ) {
+
+  std::string program = "(f x);c\n )";
+
+  Lexer lexer(program);
+
+  REQUIRE( lexer.next() == "(" );
+  REQUIRE( lexer.peek() == "f" );
+  REQUIRE( lexer.next() == "f" );
+  REQUIRE( lexer.next() == "x" );
+  REQUIRE( lexer.next() == ")" );
+  REQUIRE( lexer.next() == ")" );
+  REQUIRE( lexer.atEnd() );
+  REQUIRE( lexer.peek().empty() );
+}
+
+TEST_CASE( "Test Lexer across scanner blocks", "[tokenize]" ) {
+
+  // tokens, whitespace runs and comments that cross 64 byte blocks
+  std::string name(100, 'a');
+  std::string program = "\t\v\f\r (" + name + std::string(70, ' ') + "b;" + std::string(80, 'c') + "\n" + name + ")";
+
+  Lexer lexer(program);
+
+  REQUIRE( lexer.next() == "(" );
+  REQUIRE( lexer.next() == name );
+  REQUIRE( lexer.next() == "b" );
+  REQUIRE( lexer.next() == name );
+  REQUIRE( lexer.next() == ")" );
+  REQUIRE( lexer.atEnd() );
+}
+
+TEST_CASE( "Test CharScanner classifiers agree", "[tokenize]" ) {
+
+  // every byte value, then runs of whitespace and delimiters across
+  // blocks, ending in a partial block
+  std::string text;
+  for (int c = 0; c < 256; ++c)
+  {
+    text += static_cast<char>(c);
+  }
+  for (int i = 0; i < 300; ++i)
+  {
+    text += "( \t\n\v\f\r);ab"[(i * 7 + i / 11) % 11];
+  }
+
+  const std::string initial = scanImplementation();
+  const std::vector<const char *> names = scanImplementations();
+  REQUIRE( std::string(names.back()) == "scalar" );
+  REQUIRE_FALSE( setScanImplementation("none") );
+  REQUIRE( scanImplementation() == initial );
+
+  std::vector<std::size_t> expected;
+  for (const char * name : names)
+  {
+    REQUIRE( setScanImplementation(name) );
+    REQUIRE( std::string(scanImplementation()) == name );
+    CharScanner scanner(text);
+    std::vector<std::size_t> found;
+    for (std::size_t pos = 0; pos <= text.size(); ++pos)
+    {
+      found.push_back(scanner.skipWhitespace(pos));
+      found.push_back(scanner.findDelimiter(pos));
+    }
+    if (expected.empty())
+    {
+      expected = found;
+    }
+    INFO( name );
+    REQUIRE( found == expected );
+  }
+
+  // the scalar classifier is the reference for the others
+  REQUIRE( setScanImplementation("scalar") );
+  CharScanner scalar(text);
+  REQUIRE( scalar.skipWhitespace(0) == 0 );
+  REQUIRE( scalar.skipWhitespace(9) == 14 );
+  REQUIRE( scalar.findDelimiter(0) == 9 );
+  REQUIRE( scalar.findDelimiter(33) == '(' );
+  REQUIRE( scalar.findDelimiter(42) == ';' );
+  REQUIRE( setScanImplementation(initial) );
+}
+
+TEST_CASE( "Test Lexer reads an array literal as one token", "[tokenize]" ) {
+
+  std::string program = "(f #[1 2\n 3] x)";
+
+  Lexer lexer(program);
+
+  REQUIRE( lexer.next() == "(" );
+  REQUIRE( lexer.next() == "f" );
+  REQUIRE( lexer.next() == "#[1 2\n 3]" );
+  REQUIRE( lexer.next() == "x" );
+  REQUIRE( lexer.next() == ")" );
+  REQUIRE( lexer.atEnd() );
+
+  // a parenthesis or comment ends an array unclosed, as it ends a form
+  Lexer unclosed("(f #[1 2) 3] #[4;5]\n)");
+
+  REQUIRE( unclosed.next() == "(" );
+  REQUIRE( unclosed.next() == "f" );
+  REQUIRE( unclosed.next() == "#[1 2" );
+  REQUIRE( unclosed.next() == ")" );
+  REQUIRE( unclosed.next() == "3]" );
+  REQUIRE( unclosed.next() == "#[4" );
+  REQUIRE( unclosed.next() == ")" );
+  REQUIRE( unclosed.atEnd() );
+}
+
+TEST_CASE( "Test FormReader reads top level forms one at a time", "[tokenize]" ) {
+
+  // a form larger than one read from the stream
+  std::string big = "(f" + std::string(100000, ' ') + "x)";
+  std::istringstream iss("; leading comment\n(define a (+ 1 2)) ; (\n" + big + "\nTrue (g\n ; )\n 1) )(h");
+
+  FormReader reader(iss);
+  std::string form;
+
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(define a (+ 1 2))" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == big );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "True" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(g\n ; )\n 1)" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == ")" );
+  // an unclosed form is returned as it is
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(h" );
+  REQUIRE_FALSE( reader.next(form) );
+}
+
+TEST_CASE( "Test FormReader hands out forms of text in memory", "[tokenize]" ) {
+
+  std::string program = "(f 1)\n; c\n(g (h))";
+
+  FormReader reader{std::string_view(program)};
+  std::string_view form;
+
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(f 1)" );
+  // the forms are views of the text, not copies
+  REQUIRE( form.data() == program.data() );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(g (h))" );
+  REQUIRE_FALSE( reader.next(form) );
+}
+
+TEST_CASE( "Test FormReader reads array literals as one form", "[tokenize]" ) {
+
+  // an array larger than one read from the stream, and arrays cut short
+  // by what ends a form elsewhere
+  std::string big = "#[" + std::string(100000, ' ') + "1 2]";
+  std::istringstream iss("#[1 2 3] " + big + "\n(f #[4 ) 5] (g #[6 ; 7]\n) #[8) a#[9 #[10");
+
+  FormReader reader(iss);
+  std::string form;
+
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "#[1 2 3]" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == big );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(f #[4 )" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "5]" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "(g #[6 ; 7]\n)" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "#[8" );
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == ")" );
+  // only a token that starts with "#[" is an array
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "a#[9" );
+  // an unclosed array is returned as it is
+  REQUIRE( reader.next(form) );
+  REQUIRE( form == "#[10" );
+  REQUIRE_FALSE( reader.next(form) );
+}
@@ -1,8 +1,13 @@
 #include "catch.hpp"
 
 #include <string>
+#include <vector>
+#include <limits>
+#include <unordered_set>
+#include <stdexcept>
 
 #include "expression.hpp"
+#include "small_vector.hpp"
 
 TEST_CASE( "Test Type Inference", "[types]" ) {
 
@@ -43,9 +48,204 @@ TEST_CASE( "Test Type Inference", "[types]" ) {
 
 }
 
+TEST_CASE( "Test Type Inference of number edge cases", "[types]" ) {
+
+  Atom a;
+
+  // out of range in either direction is not a valid token
+  REQUIRE(!token_to_atom("1e400", a));
+  REQUIRE(!token_to_atom("1e-400", a));
+
+  REQUIRE(token_to_atom("+1e+0", a));
+  REQUIRE(a.type == NumberType);
+  REQUIRE(a.value.num_value == 1);
+
+  REQUIRE(token_to_atom("0x10", a));
+  REQUIRE(a.type == NumberType);
+  REQUIRE(a.value.num_value == 16);
+
+  REQUIRE(token_to_atom("0x.8", a));
+  REQUIRE(a.value.num_value == 0.5);
+
+  // the hex prefix only takes hex digits, not inf or nan
+  REQUIRE(!token_to_atom("0xinf", a));
+  REQUIRE(!token_to_atom("0XiNF", a));
+  REQUIRE(!token_to_atom("0xnan", a));
+  REQUIRE(token_to_atom("-0xinf", a));
+  REQUIRE(a.type == SymbolType);
+
+  REQUIRE(token_to_atom("-", a));
+  REQUIRE(a.type == SymbolType);
+
+  REQUIRE(token_to_atom("+-1", a));
+  REQUIRE(a.type == SymbolType);
+
+  REQUIRE(!token_to_atom("1.5.1", a));
+}
+
 TEST_CASE( "Test Expression Constructors", "[types]" ) {
 
   Expression exp1;
 
   REQUIRE(exp1 == Expression());
 }
+
+TEST_CASE( "Test deep equality and hashing of expressions", "[types]" ) {
+
+  Expression sum(Symbol("+"), std::vector<Expression>{ Expression(1.), Expression(2.) });
+  Expression other(Symbol("+"), std::vector<Expression>{ Expression(1.), Expression(3.) });
+  Expression outer(Symbol("*"), std::vector<Expression>{ sum, Expression(true) });
+
+  // tails are compared, not only heads
+  REQUIRE(sum != other);
+  REQUIRE(Expression(Symbol("*"), std::vector<Expression>{ other, Expression(true) }) != outer);
+
+  // identical trees in different storage are identical and hash alike
+  AstArena arena;
+  Expression* items = arena.allocateArray<Expression>(4);
+  new (items) Expression(1.);
+  new (items + 1) Expression(2.);
+  Expression view(Symbol("+"), ExpressionList::view(items, 2));
+  REQUIRE(view == sum);
+  REQUIRE(view.identical(sum));
+  REQUIRE(view.hash() == sum.hash());
+  REQUIRE(Expression(Symbol("*"), std::vector<Expression>{ view, Expression(true) }).identical(outer));
+
+  // trees within the tolerance are equal, but not identical
+  new (items + 2) Expression(1. + std::numeric_limits<double>::epsilon());
+  new (items + 3) Expression(2.);
+  Expression near(Symbol("+"), ExpressionList::view(items + 2, 2));
+  REQUIRE(near == sum);
+  REQUIRE(!near.identical(sum));
+  REQUIRE(Expression(Symbol("*"), std::vector<Expression>{ near, Expression(true) }) == outer);
+
+  // a list longer than its count can hold is refused, not truncated
+  REQUIRE_THROWS_AS(ExpressionList::view(items, ExpressionList::MAX_SIZE + 1), std::length_error);
+
+  // numbers hash by their bits, small ones too
+  REQUIRE(Expression(0.5).hash() != Expression(0.25).hash());
+  REQUIRE(Expression(0.).hash() != Expression(-0.).hash());
+  REQUIRE(Expression(0.) == Expression(-0.));
+  REQUIRE(!Expression(0.).identical(Expression(-0.)));
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  REQUIRE(Expression(nan).identical(Expression(nan)));
+  REQUIRE(Expression(std::make_tuple(0.5, -1.), std::make_tuple(0.25, 1.)).hash() !=
+          Expression(std::make_tuple(0.5, -1.), std::make_tuple(0.25, 0.75)).hash());
+
+  // arrays hash by their numbers, which are hashed once when they are read
+  Atom first, second, third;
+  REQUIRE(token_to_array("#[1 2.5 -300]", arena, first));
+  REQUIRE(token_to_array("#[1  2.5 -3e2]", arena, second));
+  REQUIRE(token_to_array("#[1 2.5 300]", arena, third));
+  REQUIRE(first.value.array_value.data != second.value.array_value.data);
+  REQUIRE(Expression(first).identical(Expression(second)));
+  REQUIRE(Expression(first).hash() == Expression(second).hash());
+  REQUIRE(Expression(first).hash() != Expression(third).hash());
+
+  // the numbers are parsed straight into exactly as much arena as they need
+  const std::size_t before = arena.bytesUsed();
+  REQUIRE(token_to_array("#[ 1 2\n3\t4 ]", arena, first));
+  REQUIRE(arena.bytesUsed() - before == 4 * sizeof(Number));
+  REQUIRE(first.value.array_value.size == 4);
+  REQUIRE(first.value.array_value.data[3] == 4.);
+  REQUIRE(token_to_array("#[  ]", arena, first));
+  REQUIRE(first.value.array_value.size == 0);
+
+  std::unordered_set<Expression, std::hash<Expression>, IdenticalExpression> seen = { sum, outer };
+  REQUIRE(seen.count(view) == 1);
+  REQUIRE(seen.count(near) == 0);
+  REQUIRE(seen.count(other) == 0);
+}
+
+TEST_CASE( "Test Atom values share storage", "[types]" ) {
+
+  Expression arc(std::make_tuple(0.,0.), std::make_tuple(1.,0.), 1.5);
+  Expression copy = arc;
+
+  REQUIRE(copy == arc);
+  REQUIRE(copy.head.value.arc_value.span == 1.5);
+
+  // an atom holds one value at a time, its tag says which
+  copy.head.type = NumberType;
+  copy.head.value.num_value = 2;
+  REQUIRE(copy == Expression(2.));
+  REQUIRE(sizeof(Atom) < 2*sizeof(Arc));
+}
+
+TEST_CASE( "Test Expression copies share their tail", "[types]" ) {
+
+  std::vector<Expression> points;
+  for (int i = 0; i < 1000; ++i)
+  {
+    points.push_back(Expression(std::make_tuple(double(i), 0.)));
+  }
+  Expression list(Symbol("points"), std::move(points));
+
+  Expression copy = list;
+  REQUIRE(copy == list);
+  REQUIRE(&copy.tail[0] == &list.tail[0]);
+
+  // the block outlives the expression it was built for
+  list = Expression();
+  REQUIRE(copy.tail.size() == 1000);
+  REQUIRE(copy.tail[999] == Expression(std::make_tuple(999., 0.)));
+}
+
+TEST_CASE( "Test SmallVector spills past its inline capacity", "[types]" ) {
+
+  SmallVector<Expression, 2> list;
+  REQUIRE(list.empty());
+
+  list.push_back(Expression(1.));
+  list.emplace_back(Expression(2.));
+  const Expression* inlineData = list.data();
+
+  // the third element moves everything to the heap
+  list.push_back(Expression(3.));
+  REQUIRE(list.size() == 3);
+  REQUIRE(list.data() != inlineData);
+  REQUIRE(list[0] == Expression(1.));
+  REQUIRE(list.back() == Expression(3.));
+
+  list.truncate(1);
+  REQUIRE(list.size() == 1);
+  REQUIRE(*list.begin() == Expression(1.));
+
+  // an element of the vector itself can be pushed while it grows
+  SmallVector<std::string, 2> names;
+  names.push_back(std::string(100, 'a'));
+  names.push_back(std::string(100, 'b'));
+  names.push_back(names[0]);
+  names.emplace_back(names[1]);
+  REQUIRE(names.size() == 4);
+  REQUIRE(names[2] == std::string(100, 'a'));
+  REQUIRE(names[3] == std::string(100, 'b'));
+}
+
+TEST_CASE( "Test Symbol interning", "[types]" ) {
+
+  Symbol a("var");
+  Symbol b(std::string("var"));
+  Symbol c("other");
+
+  REQUIRE(a == b);
+  REQUIRE(a.id() == b.id());
+  REQUIRE(a != c);
+  REQUIRE(a.str() == "var");
+  REQUIRE(Symbol().str().empty());
+
+  // names stay where they are while the table grows over many chunks
+  const std::string * name = &a.str();
+  std::vector<Symbol> many;
+  for (int i = 0; i < 10000; ++i)
+  {
+    many.push_back(Symbol("name" + std::to_string(i)));
+  }
+  REQUIRE(&a.str() == name);
+  REQUIRE(many[0].str() == "name0");
+  REQUIRE(many[9999].str() == "name9999");
+  REQUIRE(Symbol("name5000") == many[5000]);
+
+  // symbols are ids, so atoms no longer hold the name themselves
+  REQUIRE(sizeof(Symbol) == sizeof(Symbol::IdType));
+}
@@ -0,0 +1,47 @@
+#include "text_hash.hpp"
+
+// system includes
+#include <cstring>
+
+namespace
+{
+  std::uint64_t rotate(std::uint64_t x, unsigned bits) noexcept
+  {
+    return (x << bits) | (x >> (64 - bits));
+  }
+
+  // spread every input bit over the whole word
+  std::uint64_t finish(std::uint64_t x) noexcept
+  {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+}
+
+TextHash::TextHash(std::string_view text) noexcept
+{
+  // The lanes start apart and take each word with different multipliers
+  // and rotations, so a collision in one says nothing about the other
+  std::uint64_t a = 0x9e3779b97f4a7c15ull ^ text.size();
+  std::uint64_t b = 0xc2b2ae3d27d4eb4full + text.size();
+
+  const char * data = text.data();
+  std::size_t left = text.size();
+  std::uint64_t word;
+  for (; left >= 8; data += 8, left -= 8)
+  {
+    std::memcpy(&word, data, 8);
+    a = rotate(a ^ word, 29) * 0x87c37b91114253d5ull;
+    b = rotate(b + word, 37) * 0x4cf5ad432745937full;
+  }
+
+  // The last bytes are padded with zeros, the length tells them apart
+  word = 0;
+  std::memcpy(&word, data, left);
+  a = rotate(a ^ word, 29) * 0x87c37b91114253d5ull;
+  b = rotate(b + word, 37) * 0x4cf5ad432745937full;
+
+  low = finish(a ^ rotate(b, 17));
+  high = finish(b + a);
+}
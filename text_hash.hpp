@@ -0,0 +1,31 @@
+#ifndef TEXT_HASH_HPP
+#define TEXT_HASH_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// A 128-bit hash of a text, made of two 64-bit lanes mixed differently
+// in one pass over it. It is fast, not cryptographic: each lane can be
+// inverted word by word, so colliding texts are easy to construct. A
+// different hash rules a text out, an equal one must be confirmed by
+// comparing the texts
+class TextHash
+{
+public:
+  TextHash() noexcept: low(0), high(0){};
+  explicit TextHash(std::string_view text) noexcept;
+
+  bool operator==(const TextHash & hash) const noexcept { return low == hash.low && high == hash.high; }
+  bool operator!=(const TextHash & hash) const noexcept { return !(*this == hash); }
+
+  // one lane, for keying hash tables
+  std::size_t value() const noexcept { return static_cast<std::size_t>(low); }
+
+private:
+  std::uint64_t low;
+  std::uint64_t high;
+};
+
+#endif
@@ -57,3 +57,80 @@ TokenSequenceType tokenize(std::istream & seq)
 	
   return tokens;
 }
+
+
+Lexer::Lexer(std::string_view source): source(source), scanner(source), pos(0)
+{
+  scan();
+}
+
+TokenView Lexer::next()
+{
+  TokenView token = current;
+  scan();
+  return token;
+}
+
+// Find the token starting at or after pos and store it in current
+// Runs of whitespace, comments and token characters are scanned in bulk
+void Lexer::scan()
+{
+  const std::size_t size = source.size();
+
+  while (pos < size)
+  {
+	  pos = scanner.skipWhitespace(pos);
+	  if (pos == size)
+	  {
+		  break;
+	  }
+
+	  const char c = source[pos];
+
+	  if (c == COMMENT)
+	  {
+		  // Skip to the end of the line, the newline itself is whitespace
+		  pos = scanner.findNewline(pos);
+	  }
+	  else if (c == OPEN || c == CLOSE)
+	  {
+		  current = source.substr(pos, 1);
+		  ++pos;
+		  return;
+	  }
+	  else if (c == ARRAY_OPEN[0] && source.compare(pos, 2, ARRAY_OPEN) == 0)
+	  {
+		  // An array literal runs to its closing bracket, whitespace and
+		  // all. A parenthesis or comment before it ends it unclosed, so
+		  // the parser rejects the literal and not the form around it
+		  const std::size_t stop = source.find_first_of(ARRAY_ENDS, pos + 2);
+		  const std::size_t end = stop == std::string_view::npos ? size : source[stop] == ARRAY_CLOSE ? stop + 1 : stop;
+		  current = source.substr(pos, end - pos);
+		  pos = end;
+		  return;
+	  }
+	  else
+	  {
+		  // A token runs until the next delimiter, a comment also ends it
+		  const std::size_t start = pos;
+		  pos = scanner.findDelimiter(pos);
+		  current = source.substr(start, pos - start);
+		  return;
+	  }
+  }
+
+  current = TokenView();
+}
+
+TokenViewSequenceType tokenize(std::string_view source)
+{
+  TokenViewSequenceType tokens;
+
+  Lexer lexer(source);
+  while (!lexer.atEnd())
+  {
+	  tokens.push_back(lexer.next());
+  }
+
+  return tokens;
+}
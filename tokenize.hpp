@@ -3,16 +3,65 @@
 
 #include <istream>
 #include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "char_scan.hpp"
 
 typedef std::deque<std::string> TokenSequenceType;
 
+// A TokenView is a token that refers into the buffer it was read from
+// instead of owning a copy of its characters
+typedef std::string_view TokenView;
+typedef std::vector<TokenView> TokenViewSequenceType;
+
 const char OPEN = '(';
 const char CLOSE = ')';
 const char COMMENT = ';';
 
+// An array literal is ARRAY_OPEN, numbers separated by whitespace, and
+// ARRAY_CLOSE. The Lexer hands it out as a single token
+const char ARRAY_OPEN[] = "#[";
+const char ARRAY_CLOSE = ']';
+
+// An array literal ends at the first of these. Only ARRAY_CLOSE closes
+// it, the others end it unclosed, as they are structure everywhere else
+// and every scanner must agree on where a form ends
+const char ARRAY_ENDS[] = { ARRAY_CLOSE, OPEN, CLOSE, COMMENT, '\0' };
+
 // split string into a list of tokens where a token is one of
 // OPEN or CLOSE or a space-delimited string
 // ignores any whitespace and from any ";" to end-of-line
 TokenSequenceType tokenize(std::istream & seq);
 
+// A Lexer hands out the tokens of a contiguous buffer one at a time,
+// so a parser can pull them on demand instead of building a token list
+class Lexer
+{
+public:
+  explicit Lexer(std::string_view source);
+
+  // true when every token has been consumed
+  bool atEnd() const noexcept { return current.empty(); }
+
+  // the current token, empty at end of input
+  TokenView peek() const noexcept { return current; }
+
+  // return the current token and move on to the next one
+  TokenView next();
+
+private:
+  void scan();
+
+  std::string_view source;
+  CharScanner scanner;
+  std::size_t pos;
+  TokenView current;
+};
+
+// same as above for a contiguous buffer, but the tokens are views into
+// source, so they are only valid as long as source is
+TokenViewSequenceType tokenize(std::string_view source);
+
 #endif
@@ -7,8 +7,11 @@
 #include "tokenize.hpp"
 #include "interpreter.hpp"
 #include "interpreter_semantic_error.hpp"
+#include "ast_arena.hpp"
 
 #include <sstream>
+#include <string>
+#include <cmath>
 using namespace std;
 
 static Expression run(const std::string& program)
@@ -98,6 +101,54 @@ TEST_CASE("Stream operator function", "[expression]")
     }
 }
 
+TEST_CASE("Expression tails", "[expression]")
+{
+    SECTION("Owned tail is shared by copies")
+    {
+        std::vector<Expression> operands = { Expression(1.), Expression(2.) };
+        Expression exp(std::string("+"), operands);
+        Expression copy = exp;
+
+        REQUIRE(copy.tail.size() == 2);
+        REQUIRE(copy.tail[1] == Expression(2.));
+        REQUIRE(copy.tail.begin() == exp.tail.begin());
+
+        exp = Expression();
+        REQUIRE(copy.tail[0] == Expression(1.));
+    }
+
+    SECTION("Arena tail is shared by copies")
+    {
+        AstArena arena;
+        Expression* items = arena.allocateArray<Expression>(2);
+        new (items) Expression(1.);
+        new (items + 1) Expression(2.);
+
+        Expression exp(std::string("+"), ExpressionList::view(items, 2));
+        Expression copy = exp;
+
+        REQUIRE(copy.tail.size() == 2);
+        REQUIRE(copy.tail.begin() == items);
+        REQUIRE(arena.bytesUsed() == 2 * sizeof(Expression));
+    }
+}
+
+TEST_CASE("Hash-consed subexpressions", "[expression]")
+{
+    Interpreter interp;
+    AstArena arena;
+    HashConsTable table;
+    Lexer lexer("(begin (point 0 0) (point 0 0) (+ (point 0 0) 1) (point 0 -0))");
+    Expression exp = interp.parseExpression(lexer, arena, &table);
+
+    // equal subtrees share one tail, and bitwise different numbers do not
+    REQUIRE(exp.tail[0].tail.begin() == exp.tail[1].tail.begin());
+    REQUIRE(exp.tail[2].tail[0].tail.begin() == exp.tail[0].tail.begin());
+    REQUIRE(exp.tail[3].tail.begin() != exp.tail[0].tail.begin());
+    REQUIRE(table.sharedCount() == 2);
+    REQUIRE(exp.tail[3] == exp.tail[0]);
+}
+
 TEST_CASE("Token to atom conversion with edge cases", "[expression]")
 {
     Atom atom;
@@ -394,6 +445,87 @@ TEST_CASE("Logical and Arithmetic Procedures", "[interpreter]")
     }
 }
 
+TEST_CASE("Procedures write their result in place", "[environment]")
+{
+    Atom args[3];
+    args[0] = Expression(2.0).head;
+    args[1] = Expression(3.0).head;
+    args[2] = Expression(4.0).head;
+
+    Atom result;
+    ADDProcedure(Arguments(args, 3), result);
+    REQUIRE(Expression(result) == Expression(9.0));
+
+    lessThanProcedure(Arguments(args + 1, 2), result);
+    REQUIRE(Expression(result) == Expression(true));
+
+    // the arguments are only read
+    REQUIRE(Expression(args[0]) == Expression(2.0));
+    REQUIRE_THROWS_AS(divideProcedure(Arguments(args, 1), result), InterpreterSemanticError);
+
+    // the environment checks the arguments before applying a procedure
+    Environment env;
+    args[2] = Expression(true).head;
+    REQUIRE_THROWS_AS(env.evaluateProcedure(Symbol("+"), args, 3, result), InterpreterSemanticError);
+    env.evaluateProcedure(Symbol("*"), args, 2, result);
+    REQUIRE(Expression(result) == Expression(6.0));
+}
+
+TEST_CASE("Memoized procedures give the values of the calls they stand for", "[environment]")
+{
+    Environment env;
+    env.setMemoCapacity(DEFAULT_MEMO_ENTRIES);
+
+    // each angle is computed once, and -0 is a different call from 0
+    const double angles[] = {0.5, -0.0, 0.0, 0.5, -0.0, 0.0, 0.5};
+    for (double angle : angles)
+    {
+        Atom args[1];
+        args[0] = Expression(angle).head;
+        Atom result;
+        env.evaluateProcedure(Symbol("sin"), args, 1, result);
+        REQUIRE(result.type == NumberType);
+        REQUIRE(std::signbit(result.value.num_value) == std::signbit(std::sin(angle)));
+        REQUIRE(result.value.num_value == std::sin(angle));
+    }
+    REQUIRE(env.memoStats().misses == 3);
+    REQUIRE(env.memoStats().hits == 4);
+
+    // calls that fail are not kept, and cheap procedures are not memoized
+    Atom args[2];
+    args[0] = Expression(2.0).head;
+    args[1] = Expression(true).head;
+    Atom result;
+    REQUIRE_THROWS_AS(env.evaluateProcedure(Symbol("pow"), args, 2, result), InterpreterSemanticError);
+    REQUIRE_THROWS_AS(env.evaluateProcedure(Symbol("pow"), args, 2, result), InterpreterSemanticError);
+    args[1] = Expression(3.0).head;
+    env.evaluateProcedure(Symbol("+"), args, 2, result);
+    REQUIRE(Expression(result) == Expression(5.0));
+    REQUIRE(env.memoStats().hits + env.memoStats().misses == 7);
+
+    // a cache set up again starts empty and still memoizes the costly ones
+    env.setMemoCapacity(DEFAULT_MEMO_ENTRIES);
+    env.evaluateProcedure(Symbol("sin"), args, 1, result);
+    env.evaluateProcedure(Symbol("sin"), args, 1, result);
+    env.evaluateProcedure(Symbol("+"), args, 2, result);
+    REQUIRE(env.memoStats().misses == 1);
+    REQUIRE(env.memoStats().hits == 1);
+
+    // a loop over a few angles is answered from the cache
+    Interpreter interp;
+    interp.setMemoization(DEFAULT_MEMO_ENTRIES);
+    std::string program = "(begin (define a (/ pi 3))";
+    for (int i = 0; i < 50; ++i)
+    {
+        program += " (arctan (sin a) (cos (* a " + std::to_string(i % 4) + ")))";
+    }
+    program += ")";
+    std::istringstream iss(program);
+    REQUIRE(interp.parse(iss));
+    REQUIRE(interp.eval() == run(program));
+    REQUIRE(interp.memoStats().hits > 10 * interp.memoStats().misses);
+}
+
 TEST_CASE("Test for unsupported operation", "[interpreter]")
 {
     std::string program = "(unsupportedOp 1 2)";